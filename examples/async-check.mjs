@@ -0,0 +1,60 @@
+import {
+  CommandBuffer,
+  convertPixels,
+  convertPixelsAsync,
+  decimateMinMax,
+  decimateMinMaxAsync,
+  renderCommands,
+  renderCommandsAsync,
+} from "../lib/index.mjs";
+
+// Runs every helper with an async variant both ways and exits with 1 unless
+// the results are equal. New glyphs are added to the atlas while text is
+// still being drawn on a worker, as a program drawing labels would.
+let failed = 0;
+const bytes = (array) => Buffer.from(array.buffer, array.byteOffset, array.byteLength);
+const check = (name, sync, async) => {
+  const equal = sync && async && bytes(sync).equals(bytes(async));
+  console.log(`${name}: ${equal ? "equal" : "DIFFERENT"}`);
+  if (!equal) failed++;
+};
+
+const width = 1023;
+const height = 517;
+const pixels = Buffer.alloc(width * height * 4);
+for (let i = 0; i < pixels.length; i++) pixels[i] = (i * 7919) & 0xff;
+for (const [from, to] of [
+  ["rgba", "bgra"],
+  ["rgba", "rgb"],
+  ["bgra_premul", "rgba"],
+]) {
+  check(
+    `convert ${from} -> ${to}`,
+    convertPixels(pixels, width, height, from, to),
+    await convertPixelsAsync(pixels, width, height, from, to),
+  );
+}
+
+const samples = new Float64Array(1_000_003);
+for (let i = 0; i < samples.length; i++) samples[i] = Math.sin(i / 1000) + (i % 7) / 10;
+check("decimate f64", decimateMinMax(samples, 997), await decimateMinMaxAsync(samples, 997));
+const floats = Float32Array.from(samples);
+check("decimate f32", decimateMinMax(floats, 997), await decimateMinMaxAsync(floats, 997));
+
+const commands = new CommandBuffer();
+commands.color(255, 255, 255).clear();
+for (let i = 0; i < 400; i++) {
+  commands.color(i % 255, (i * 7) % 255, (i * 13) % 255);
+  commands.rect((i * 37) % width, (i * 53) % height, 40, 30);
+  commands.text(`async ${i}`, (i * 41) % width, (i * 29) % height, { font: "14px sans-serif" });
+}
+const expected = renderCommands(commands, width, height);
+const pending = renderCommandsAsync(commands, width, height);
+// other fonts and codepoints reach the atlas while the worker reads it
+const labels = new CommandBuffer();
+for (let codepoint = 0x100; codepoint < 0x300; codepoint++)
+  labels.text(String.fromCodePoint(codepoint), 10, 10, { font: `${10 + (codepoint % 12)}px serif` });
+renderCommands(labels, 64, 64);
+check("render", expected, await pending);
+
+if (failed) process.exitCode = 1;
@@ -0,0 +1,47 @@
+import {
+  convertPixels,
+  convertKernel,
+  setConvertSimd,
+  setRasterThreads,
+} from "../lib/index.mjs";
+
+// Converts a 4K frame between pixel formats with the SIMD kernel and the
+// scalar path on one thread and prints the throughput of both in GB/s,
+// counting the bytes read and written.
+const width = 3840;
+const height = 2160;
+const runs = 10;
+const sizes = { rgb: 3, rgba: 4, bgra: 4, rgba_premul: 4, bgra_premul: 4 };
+const pairs = [
+  ["rgba", "bgra"],
+  ["rgb", "rgba"],
+  ["rgba", "rgb"],
+  ["bgra_premul", "rgba"],
+  ["rgba", "bgra_premul"],
+];
+
+const source = Buffer.alloc(width * height * 4);
+for (let i = 0; i < source.length; i++) source[i] = (i * 7919) & 0xff;
+
+const throughput = (from, to) => {
+  convertPixels(source, width, height, from, to);
+  const start = performance.now();
+  for (let i = 0; i < runs; i++) convertPixels(source, width, height, from, to);
+  const seconds = (performance.now() - start) / 1000 / runs;
+  return (width * height * (sizes[from] + sizes[to])) / seconds / 1e9;
+};
+
+setRasterThreads(1);
+setConvertSimd(true);
+const kernel = convertKernel();
+for (const [from, to] of pairs) {
+  setConvertSimd(true);
+  const simd = throughput(from, to);
+  setConvertSimd(false);
+  const scalar = throughput(from, to);
+  console.log(
+    `${from} -> ${to}: ${kernel} ${simd.toFixed(2)} GB/s, scalar ${scalar.toFixed(2)} GB/s, ${(simd / scalar).toFixed(2)}x`,
+  );
+}
+setConvertSimd(true);
+setRasterThreads(0);
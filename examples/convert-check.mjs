@@ -0,0 +1,35 @@
+import { convertKernel, convertPixels, setConvertSimd } from "../lib/index.mjs";
+
+// Converts every pair of pixel formats with the SIMD kernel and the scalar
+// path and exits with 1 unless the output is byte for byte equal. Widths run
+// through every remainder of the vector loops and the source starts at an
+// odd offset so no load is aligned.
+const formats = ["rgb", "rgba", "bgra", "rgba_premul", "bgra_premul"];
+const height = 3;
+
+const storage = Buffer.alloc(70 * height * 4 + 1);
+for (let i = 0; i < storage.length; i++) storage[i] = ((i * 7919) >> 2) & 0xff;
+
+setConvertSimd(true);
+const kernel = convertKernel();
+let failed = 0;
+for (const from of formats) {
+  for (const to of formats) {
+    const mismatched = [];
+    for (let width = 1; width <= 70; width++) {
+      const source = storage.subarray(1, 1 + width * height * 4);
+      setConvertSimd(true);
+      const simd = convertPixels(source, width, height, from, to);
+      setConvertSimd(false);
+      const scalar = convertPixels(source, width, height, from, to);
+      if (!simd || !scalar || !simd.equals(scalar)) mismatched.push(width);
+    }
+    console.log(
+      `${from} -> ${to}: ${mismatched.length ? `DIFFERENT at widths ${mismatched.join(", ")}` : "equal"}`,
+    );
+    if (mismatched.length) failed++;
+  }
+}
+setConvertSimd(true);
+console.log(`kernel ${kernel}`);
+if (failed) process.exitCode = 1;
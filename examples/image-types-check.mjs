@@ -0,0 +1,73 @@
+import Window, { imageTypeInfo } from "../lib/index.mjs";
+
+// Checks the bytes per pixel and GL enums of every buffer type and how
+// palettes and window/level are validated, exits with 1 on a mismatch.
+const GL = {
+  UNSIGNED_BYTE: 0x1401,
+  UNSIGNED_SHORT: 0x1403,
+  FLOAT: 0x1406,
+  HALF_FLOAT: 0x140b,
+  RED: 0x1903,
+  RGB: 0x1907,
+  RGBA: 0x1908,
+  RGB8: 0x8051,
+  RGBA8: 0x8058,
+  RGB10_A2: 0x8059,
+  BGRA: 0x80e1,
+  R16: 0x822a,
+  R32F: 0x822e,
+  R8UI: 0x8232,
+  R16UI: 0x8234,
+  UNSIGNED_INT_2_10_10_10_REV: 0x8368,
+  RGBA16F: 0x881a,
+  RED_INTEGER: 0x8d94,
+};
+// [pixel size, internal format, format, component type]
+const expected = {
+  rgba: [4, GL.RGBA8, GL.RGBA, GL.UNSIGNED_BYTE],
+  rgb: [3, GL.RGB8, GL.RGB, GL.UNSIGNED_BYTE],
+  bgra: [4, GL.RGBA8, GL.BGRA, GL.UNSIGNED_BYTE],
+  r32f: [4, GL.R32F, GL.RED, GL.FLOAT],
+  r16: [2, GL.R16, GL.RED, GL.UNSIGNED_SHORT],
+  indexed8: [1, GL.R8UI, GL.RED_INTEGER, GL.UNSIGNED_BYTE],
+  rgba16f: [8, GL.RGBA16F, GL.RGBA, GL.HALF_FLOAT],
+  r16ui: [2, GL.R16UI, GL.RED_INTEGER, GL.UNSIGNED_SHORT],
+  rgb10_a2: [4, GL.RGB10_A2, GL.RGBA, GL.UNSIGNED_INT_2_10_10_10_REV],
+};
+
+let failed = 0;
+const check = (name, ok) => {
+  console.log(`${name}: ${ok ? "ok" : "FAILED"}`);
+  if (!ok) failed++;
+};
+
+for (const [type, values] of Object.entries(expected)) {
+  const info = imageTypeInfo(type);
+  const actual = info && [info.pixelSize, info.internalFormat, info.format, info.dataType];
+  check(type, actual && actual.every((value, i) => value === values[i]));
+}
+check("unknown type", imageTypeInfo("rgba32") === null);
+
+const window = new Window("image types", 64, 64);
+window.create();
+const indices = Buffer.alloc(64 * 64);
+for (let i = 0; i < indices.length; i++) indices[i] = i & 0xff;
+window.updateBuffer(indices, 64, 64, "indexed8");
+check("palette", window.setPalette([[255, 0, 0], [0, 0, 255, 128]], 3));
+check("palette last entry", window.setPalette([[0, 255, 0]], 255));
+check("palette past 255 rejected", !window.setPalette([[0, 255, 0], [0, 0, 0]], 255));
+window.updateBuffer(new Uint16Array(64 * 64), 64, 64, "r16ui");
+check("window/level", window.setWindowLevel(0.25, 0.4));
+check("zero window rejected", !window.setWindowLevel(0, 0.5));
+check("negative window rejected", !window.setWindowLevel(-1, 0.5));
+check("window/level reset", window.setWindowLevel(1, 0.5));
+// a filled buffer that changes pixel size is cleared to the new size, an
+// upload at the old size would read past the end of the allocation
+window.updateBuffer(Buffer.alloc(64 * 64 * 3, 200), 64, 64, "rgb");
+check("rgb -> rgba", window.setColorType("rgba"));
+window.force_render();
+check("rgba -> rgba16f", window.setColorType("rgba16f"));
+window.force_render();
+window.close();
+
+if (failed) process.exitCode = 1;
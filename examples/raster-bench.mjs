@@ -0,0 +1,67 @@
+import Window, {
+  CommandBuffer,
+  setRasterThreads,
+  rasterThreads,
+} from "../lib/index.mjs";
+
+// Draws the same 4K command buffer with 1 up to N raster threads and prints
+// the time per frame and the speedup over a single thread.
+const width = 3840;
+const height = 2160;
+const frames = 5;
+
+let seed = 1;
+const random = () => {
+  seed = (seed * 1103515245 + 12345) % 2147483648;
+  return seed / 2147483648;
+};
+
+const commands = new CommandBuffer(1 << 20);
+commands.color(255, 255, 255).clear();
+for (let i = 0; i < 4000; i++) {
+  commands.color(random() * 255, random() * 255, random() * 255, 160);
+  const x = random() * width;
+  const y = random() * height;
+  switch (i % 4) {
+    case 0:
+      commands.rect(x, y, random() * 200, random() * 200);
+      break;
+    case 1:
+      commands.lineWidth(1 + random() * 3).line(x, y, random() * width, random() * height);
+      break;
+    case 2:
+      commands.arc(x, y, 5 + random() * 60, 0, Math.PI * 2, i % 8 === 2);
+      break;
+    default: {
+      const points = [];
+      for (let p = 0, px = x, py = y; p < 64; p++) {
+        points.push(px, py);
+        px += random() * 40 - 20;
+        py += random() * 40 - 20;
+      }
+      commands.polyline(points);
+    }
+  }
+}
+
+const window = new Window("raster bench", 960, 540);
+window.create();
+window.updateBuffer(Buffer.alloc(width * height * 4), width, height, "rgba");
+
+setRasterThreads(0);
+const cores = rasterThreads();
+let single = 0;
+for (let threads = 1; threads <= cores; threads *= 2) {
+  setRasterThreads(threads);
+  window.executeCommands(commands);
+  const start = performance.now();
+  for (let i = 0; i < frames; i++) window.executeCommands(commands);
+  const ms = (performance.now() - start) / frames;
+  if (threads === 1) single = ms;
+  console.log(
+    `${threads} threads: ${ms.toFixed(1)} ms/frame, ${(single / ms).toFixed(2)}x`,
+  );
+  if (threads < cores && threads * 2 > cores) threads = cores / 2;
+}
+setRasterThreads(0);
+window.close();
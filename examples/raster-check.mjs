@@ -0,0 +1,78 @@
+import { CommandBuffer, renderCommands, setRasterThreads } from "../lib/index.mjs";
+
+// Draws random command buffers once on a single thread and once split into
+// tiles on the thread pool and exits with 1 unless both are byte for byte
+// equal. Four threads are forced so the tiled path runs on one core too.
+const sizes = [
+  [256, 256],
+  [333, 517],
+  [1000, 701],
+  [257, 1],
+  [64, 2000],
+];
+const types = ["rgba", "rgb", "bgra"];
+
+let seed = 1;
+const random = () => {
+  seed = (seed * 1103515245 + 12345) % 2147483648;
+  return seed / 2147483648;
+};
+
+const record = (width, height) => {
+  const commands = new CommandBuffer(1 << 16);
+  commands.color(255, 255, 255).clear();
+  for (let i = 0; i < 3000; i++) {
+    commands.color(random() * 255, random() * 255, random() * 255, 40 + random() * 215);
+    const x = random() * width;
+    const y = random() * height;
+    switch (i % 7) {
+      case 0:
+        commands.rect(x, y, random() * 200, random() * 200);
+        break;
+      case 1:
+        commands.lineWidth(0.5 + random() * 4).line(x, y, random() * width, random() * height);
+        break;
+      case 2:
+        commands.arc(x, y, 2 + random() * 60, random() * 6, random() * 6, i % 2 === 0);
+        break;
+      case 3: {
+        const points = [];
+        for (let p = 0, px = x, py = y; p < 32; p++) {
+          points.push(px, py);
+          px += random() * 40 - 20;
+          py += random() * 40 - 20;
+        }
+        commands.polyline(points);
+        break;
+      }
+      case 4:
+        commands.clip(x - 50, y - 50, random() * 300, random() * 300);
+        break;
+      case 5:
+        commands.clip();
+        break;
+      default:
+        commands.text(`label ${i}`, x, y, {
+          align: ["left", "center", "right"][i % 3],
+          baseline: ["alphabetic", "top", "middle"][i % 3],
+        });
+    }
+  }
+  return commands;
+};
+
+let failed = 0;
+for (const [width, height] of sizes) {
+  const commands = record(width, height);
+  for (const type of types) {
+    setRasterThreads(1);
+    const serial = renderCommands(commands, width, height, type);
+    setRasterThreads(4);
+    const parallel = renderCommands(commands, width, height, type);
+    const equal = serial && parallel && serial.equals(parallel);
+    console.log(`${width}x${height} ${type}: ${equal ? "equal" : "DIFFERENT"}`);
+    if (!equal) failed++;
+  }
+}
+setRasterThreads(0);
+if (failed) process.exitCode = 1;
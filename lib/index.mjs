@@ -3,6 +3,7 @@ import { fileURLToPath } from "node:url";
 import { createCanvas } from "canvas";
 import {spawn} from "child_process";
 import fs from "node:fs";
+import { createRequire } from "node:module";
 let bunImports = null;
 const isBun = process.versions.bun !== undefined;
 
@@ -10,11 +11,11 @@ if (isBun) {
   bunImports = await import("bun:ffi");
 } else {
 
+  const require = createRequire(import.meta.url);
   bunImports = {
-    dlopen: async (path) => {
-      const res = await import("bindings");
+    dlopen: (path) => {
       return {
-        symbols: res.default(path),
+        symbols: require("bindings")(path),
       };
     },
     FFIType: {},
@@ -22,8 +23,11 @@ if (isBun) {
   };
 }
 const { dlopen, FFIType, ptr, JSCallback: jsCallbackConstructor } = bunImports;
+// native events may fire off the JS thread once rendering moves elsewhere,
+// threadsafe callbacks are queued onto the JS thread instead of running there
 const JSCallback = (func, args) => {
-  if (isBun) return new jsCallbackConstructor(func, args);
+  if (isBun)
+    return new jsCallbackConstructor(func, { ...args, threadsafe: true });
   func.close = () => {};
   return func;
 };
@@ -36,7 +40,7 @@ const path = isBun
       process.platform === "darwin" ? "libbun-ui.dylib" : "libbun-ui.so",
     )
   : "bun-ui.node";
-const lib = await dlopen(path, {
+const symbolTypes = {
   create_window: {
     args: [
       FFIType.cstring,
@@ -52,10 +56,176 @@ const lib = await dlopen(path, {
     args: [FFIType.ptr],
     returns: FFIType.u8,
   },
+  request_render: {
+    args: [FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  render_all: {
+    args: [],
+    returns: FFIType.u32,
+  },
+  set_program_cache_dir: {
+    args: [FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  prewarm: {
+    args: [FFIType.u8],
+    returns: FFIType.u8,
+  },
+  get_startup_timings: {
+    args: [FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  get_upload_stats: {
+    args: [FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  get_image_type_info: {
+    args: [FFIType.ptr, FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  convert_pixels: {
+    args: [
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+    ],
+    returns: FFIType.u8,
+  },
+  set_convert_simd: {
+    args: [FFIType.u8],
+    returns: FFIType.u8,
+  },
+  get_convert_kernel: {
+    args: [],
+    returns: FFIType.u8,
+  },
+  decimate_minmax: {
+    args: [FFIType.ptr, FFIType.u8, FFIType.u32, FFIType.u32, FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  rasterize_commands: {
+    args: [
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+    ],
+    returns: FFIType.u8,
+  },
+  set_thread_count: {
+    args: [FFIType.u32],
+    returns: FFIType.u8,
+  },
+  get_thread_count: {
+    args: [],
+    returns: FFIType.u32,
+  },
+  add_font: {
+    args: [FFIType.f32, FFIType.f32],
+    returns: FFIType.i32,
+  },
+  atlas_add_glyph: {
+    args: [
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.f32,
+      FFIType.f32,
+      FFIType.f32,
+    ],
+    returns: FFIType.u8,
+  },
+  add_text: {
+    args: [FFIType.ptr],
+    returns: FFIType.i32,
+  },
+  remove_text: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  set_text: {
+    args: [
+      FFIType.ptr,
+      FFIType.i32,
+      FFIType.u32,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.f32,
+      FFIType.f32,
+      FFIType.u8,
+      FFIType.u8,
+    ],
+    returns: FFIType.u8,
+  },
+  set_text_style: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8, FFIType.u8, FFIType.u8, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  set_text_visible: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  execute_commands: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  add_scene_node: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.i32,
+  },
+  remove_scene_node: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  set_scene_node: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_scene_node_offset: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_scene_node_visible: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  set_scene_node_z: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  set_scene_background: {
+    args: [FFIType.ptr, FFIType.u8, FFIType.u8, FFIType.u8, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  get_scene_drawn_pixels: {
+    args: [FFIType.ptr],
+    returns: FFIType.f64,
+  },
   move_buffer_to_image: {
     args: [FFIType.ptr, FFIType.ptr, FFIType.u32, FFIType.u32],
     returns: FFIType.u8,
   },
+  move_buffer_region_to_image: {
+    args: [
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.u32,
+    ],
+    returns: FFIType.u8,
+  },
   dispose_instance: {
     args: [FFIType.ptr],
     returns: FFIType.u8,
@@ -116,7 +286,256 @@ const lib = await dlopen(path, {
     args: [FFIType.ptr, FFIType.cstring],
     returns: FFIType.u8,
   },
-});
+  range_f32: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  range_f64: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  map_range_f32: {
+    args: [
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.f64,
+      FFIType.f64,
+      FFIType.ptr,
+    ],
+    returns: FFIType.u8,
+  },
+  map_range_f64: {
+    args: [
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.f64,
+      FFIType.f64,
+      FFIType.ptr,
+    ],
+    returns: FFIType.u8,
+  },
+  nice_ticks: {
+    args: [FFIType.f64, FFIType.f64, FFIType.u32, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u32,
+  },
+  create_series_store: {
+    args: [FFIType.u32, FFIType.u32, FFIType.u8],
+    returns: FFIType.ptr,
+  },
+  dispose_series_store: {
+    args: [FFIType.ptr],
+    returns: FFIType.u8,
+  },
+  series_append: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  series_set_color: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.u8, FFIType.u8, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  series_read: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.u32, FFIType.ptr, FFIType.ptr],
+    returns: FFIType.u32,
+  },
+  series_render_scroll: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.f64, FFIType.f64, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  add_line_series: {
+    args: [FFIType.ptr, FFIType.u32],
+    returns: FFIType.i32,
+  },
+  remove_line_series: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  line_series_append: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  line_series_clear: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  line_series_style: {
+    args: [
+      FFIType.ptr,
+      FFIType.i32,
+      FFIType.u8,
+      FFIType.u8,
+      FFIType.u8,
+      FFIType.u8,
+      FFIType.f32,
+    ],
+    returns: FFIType.u8,
+  },
+  set_line_range: {
+    args: [FFIType.ptr, FFIType.f32, FFIType.f32, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_line_area: {
+    args: [FFIType.ptr, FFIType.f32, FFIType.f32, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_colormap: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_scalar_range: {
+    args: [FFIType.ptr, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_window_level: {
+    args: [FFIType.ptr, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_palette: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.u32, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_view: {
+    args: [FFIType.ptr, FFIType.f32, FFIType.f32, FFIType.f32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_mipmaps: {
+    args: [FFIType.ptr, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  add_layer: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.i32,
+  },
+  remove_layer: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  update_layer: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_layer_color_type: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.cstring],
+    returns: FFIType.u8,
+  },
+  set_layer_visible: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  set_layer_z: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  set_layer_alpha: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  add_panel: {
+    args: [FFIType.ptr],
+    returns: FFIType.i32,
+  },
+  remove_panel: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  update_panel: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_panel_color_type: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.cstring],
+    returns: FFIType.u8,
+  },
+  set_panel_rect: {
+    args: [
+      FFIType.ptr,
+      FFIType.i32,
+      FFIType.f32,
+      FFIType.f32,
+      FFIType.f32,
+      FFIType.f32,
+    ],
+    returns: FFIType.u8,
+  },
+  set_panel_visible: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  set_panel_grid: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.u32, FFIType.f32],
+    returns: FFIType.u8,
+  },
+  set_panel_mouse_callback: {
+    args: [FFIType.ptr, FFIType.callback],
+    returns: FFIType.u8,
+  },
+  set_tiled_image: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.u32, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  tiled_image_write: {
+    args: [
+      FFIType.ptr,
+      FFIType.ptr,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.u32,
+      FFIType.u32,
+    ],
+    returns: FFIType.u8,
+  },
+  set_tile_budget: {
+    args: [FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  set_waterfall: {
+    args: [FFIType.ptr, FFIType.u32, FFIType.u32, FFIType.u8],
+    returns: FFIType.u8,
+  },
+  waterfall_push_rows: {
+    args: [FFIType.ptr, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  add_scatter_set: {
+    args: [FFIType.ptr, FFIType.u32],
+    returns: FFIType.i32,
+  },
+  remove_scatter_set: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  scatter_append: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  scatter_clear: {
+    args: [FFIType.ptr, FFIType.i32],
+    returns: FFIType.u8,
+  },
+  scatter_set_palette: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.ptr, FFIType.u32],
+    returns: FFIType.u8,
+  },
+  scatter_set_density: {
+    args: [FFIType.ptr, FFIType.i32, FFIType.u8, FFIType.f32],
+    returns: FFIType.u8,
+  },
+};
+// the library is opened on first use, so importing does not load glfw or gl
+let loadedLib = null;
+let dlopenTime = 0;
+const lib = {
+  get symbols() {
+    if (!loadedLib) {
+      const start = performance.now();
+      loadedLib = dlopen(path, symbolTypes);
+      dlopenTime = performance.now() - start;
+    }
+    return loadedLib.symbols;
+  },
+};
 
 export const generateFileSavePath = () => {
   return new Promise((resolve, reject) => {
@@ -179,6 +598,348 @@ if ($SaveFile -ne "")
   });
 }
 
+const pixelSizes = {
+  rgb: 3,
+  rgba: 4,
+  bgra: 4,
+  r32f: 4,
+  r16: 2,
+  indexed8: 1,
+  rgba16f: 8,
+  r16ui: 2,
+  rgb10_a2: 4,
+};
+// stands in for a window instance in calls that work without one
+const noInstance = isBun ? null : -1;
+const cString = (value) =>
+  isBun ? Buffer.from(value + "\0", "utf-8") : value;
+
+// Node runs these on the libuv thread pool and gets a promise back, Bun FFI
+// calls are synchronous so there the async variants run on a later tick.
+// args is a function so the closure keeps the arrays alive until then.
+const nativeTask = (name, args, async) => {
+  if (!isBun) return lib.symbols[name](...args(), async);
+  if (!async) return lib.symbols[name](...args());
+  return Promise.resolve().then(() => lib.symbols[name](...args()));
+};
+// null when the native call failed
+const settle = (result, value) =>
+  result instanceof Promise
+    ? result.then((failed) => (failed ? null : value))
+    : result
+      ? null
+      : value;
+
+const convertSizes = {
+  rgb: 3,
+  rgba: 4,
+  bgra: 4,
+  rgba_premul: 4,
+  bgra_premul: 4,
+};
+// converts between "rgb", "rgba", "bgra" and the premultiplied variants into
+// a new buffer
+const convert = (buffer, w, h, from, to, async) => {
+  if (!convertSizes[from] || !convertSizes[to]) return null;
+  const out = Buffer.alloc(w * h * convertSizes[to]);
+  const args = () => [ptr(buffer), cString(from), ptr(out), cString(to), w, h];
+  return settle(nativeTask("convert_pixels", args, async), out);
+};
+export const convertPixels = (buffer, w, h, from, to) =>
+  convert(buffer, w, h, from, to, false);
+export const convertPixelsAsync = (buffer, w, h, from, to) =>
+  Promise.resolve(convert(buffer, w, h, from, to, true));
+// false forces the scalar path, for benchmarks
+export const setConvertSimd = (enabled) => {
+  lib.symbols.set_convert_simd(enabled ? 1 : 0);
+};
+export const convertKernel = () =>
+  ["scalar", "ssse3", "avx2", "neon"][lib.symbols.get_convert_kernel()];
+
+// [min0, max0, min1, max1, ...] of evenly sized buckets, for plotting far
+// more samples than there are pixels
+const decimate = (values, buckets, async) => {
+  const isDouble = values instanceof Float64Array;
+  const input = isDouble ? values : Float32Array.from(values);
+  const out = new input.constructor(buckets * 2);
+  const args = () => [
+    ptr(input),
+    isDouble ? 1 : 0,
+    input.length,
+    buckets,
+    ptr(out),
+  ];
+  return settle(nativeTask("decimate_minmax", args, async), out);
+};
+export const decimateMinMax = (values, buckets) =>
+  decimate(values, buckets, false);
+export const decimateMinMaxAsync = (values, buckets) =>
+  Promise.resolve(decimate(values, buckets, true));
+
+// draws a CommandBuffer into a new buffer without any window
+const renderCommandBuffer = (commands, w, h, type, async) => {
+  if (!convertSizes[type] || type.endsWith("_premul")) return null;
+  if (!prepareCommands(null, commands)) return null;
+  const out = Buffer.alloc(w * h * pixelSizes[type]);
+  // the worker reads a snapshot, the buffer can be recorded again meanwhile
+  const bytes = async
+    ? commands.bytes.slice(0, commands.length)
+    : commands.bytes;
+  const length = commands.length;
+  const args = () => [ptr(out), w, h, cString(type), ptr(bytes), length];
+  return settle(nativeTask("rasterize_commands", args, async), out);
+};
+export const renderCommands = (commands, w, h, type = "rgba") =>
+  renderCommandBuffer(commands, w, h, type, false);
+export const renderCommandsAsync = (commands, w, h, type = "rgba") =>
+  Promise.resolve(renderCommandBuffer(commands, w, h, type, true));
+
+// Glyphs are measured and rasterized through canvas once per font and then
+// served from these caches and the native atlas shared by all windows.
+const textFonts = new Map();
+const textAligns = { left: 0, center: 1, right: 2 };
+const textBaselines = { alphabetic: 0, top: 1, middle: 2 };
+let textContext = null;
+function getTextFont(font) {
+  let entry = textFonts.get(font);
+  if (entry) return entry;
+  if (!textContext) textContext = createCanvas(1, 1).getContext("2d");
+  textContext.font = font;
+  const metrics = textContext.measureText("Mg");
+  entry = {
+    font,
+    id: -1,
+    ascent: metrics.emHeightAscent ?? metrics.actualBoundingBoxAscent,
+    descent: metrics.emHeightDescent ?? metrics.actualBoundingBoxDescent,
+    glyphs: new Map(),
+  };
+  textFonts.set(font, entry);
+  return entry;
+}
+function getGlyph(entry, codepoint) {
+  let glyph = entry.glyphs.get(codepoint);
+  if (glyph) return glyph;
+  textContext.font = entry.font;
+  const char = String.fromCodePoint(codepoint);
+  const metrics = textContext.measureText(char);
+  const left = Math.ceil(metrics.actualBoundingBoxLeft);
+  const ascent = Math.ceil(metrics.actualBoundingBoxAscent);
+  const w = Math.max(0, left + Math.ceil(metrics.actualBoundingBoxRight));
+  const h = Math.max(0, ascent + Math.ceil(metrics.actualBoundingBoxDescent));
+  glyph = { advance: metrics.width, left, ascent, w, h, uploaded: false };
+  entry.glyphs.set(codepoint, glyph);
+  return glyph;
+}
+// without a window glyphs only reach the cpu copy of the atlas until the
+// next window draws text, false when the atlas has no room for a glyph
+function uploadGlyphs(window, entry, codepoints) {
+  if (entry.id < 0) entry.id = lib.symbols.add_font(entry.ascent, entry.descent);
+  if (entry.id < 0) return false;
+  for (const codepoint of codepoints) {
+    const glyph = getGlyph(entry, codepoint);
+    if (glyph.uploaded) continue;
+    let alpha = null;
+    if (glyph.w > 0 && glyph.h > 0) {
+      const canvas = createCanvas(glyph.w, glyph.h);
+      const ctx = canvas.getContext("2d");
+      ctx.font = entry.font;
+      ctx.fillStyle = "#fff";
+      ctx.fillText(String.fromCodePoint(codepoint), glyph.left, glyph.ascent);
+      const raw = canvas.toBuffer("raw");
+      alpha = Buffer.alloc(glyph.w * glyph.h);
+      for (let i = 0; i < alpha.length; i++) alpha[i] = raw[i * 4 + 3];
+    }
+    const failed = lib.symbols.atlas_add_glyph(
+      window ? window.instance : noInstance,
+      entry.id,
+      codepoint,
+      alpha ? ptr(alpha) : null,
+      alpha ? glyph.w : 0,
+      alpha ? glyph.h : 0,
+      -glyph.left,
+      glyph.ascent,
+      glyph.advance,
+    );
+    // left pending so a later call tries again
+    if (failed) return false;
+    glyph.uploaded = true;
+  }
+  return true;
+}
+// uploads missing glyphs and fills in the font ids of text commands
+function prepareCommands(window, commands) {
+  for (const [entry, codepoints] of commands.glyphs) {
+    if (!uploadGlyphs(window, entry, codepoints)) return false;
+  }
+  commands.glyphs.clear();
+  for (const [offset, entry] of commands.fontSlots)
+    commands.view.setUint32(offset, entry.id, true);
+  commands.fontSlots.length = 0;
+  return true;
+}
+const toCodepoints = (text) =>
+  Uint32Array.from(String(text), (char) => char.codePointAt(0));
+
+// Drawing commands recorded into one growable buffer, a window decodes all
+// of them into its buffer with a single native call. See src/raster.h.
+const commandOps = {
+  color: 1,
+  clear: 2,
+  lineWidth: 3,
+  clip: 4,
+  rect: 5,
+  line: 6,
+  polyline: 7,
+  arc: 8,
+  text: 9,
+};
+export class CommandBuffer {
+  constructor(capacity = 4096) {
+    this.bytes = new Uint8Array(capacity * 4);
+    this.view = new DataView(this.bytes.buffer);
+    this.length = 0;
+    // codepoints per font that have to be in the atlas before executing
+    this.glyphs = new Map();
+    this.fontSlots = [];
+  }
+  reset() {
+    this.length = 0;
+    this.glyphs.clear();
+    this.fontSlots.length = 0;
+    return this;
+  }
+  reserve(words) {
+    const needed = this.length + words * 4;
+    if (needed <= this.bytes.length) return;
+    const grown = new Uint8Array(Math.max(needed, this.bytes.length * 2));
+    grown.set(this.bytes.subarray(0, this.length));
+    this.bytes = grown;
+    this.view = new DataView(grown.buffer);
+  }
+  u32(value) {
+    this.view.setUint32(this.length, value, true);
+    this.length += 4;
+  }
+  f32(value) {
+    this.view.setFloat32(this.length, value, true);
+    this.length += 4;
+  }
+  color(r, g, b, a = 255) {
+    this.reserve(2);
+    this.u32(commandOps.color);
+    this.bytes.set([r, g, b, a], this.length);
+    this.length += 4;
+    return this;
+  }
+  clear() {
+    this.reserve(1);
+    this.u32(commandOps.clear);
+    return this;
+  }
+  lineWidth(width) {
+    this.reserve(2);
+    this.u32(commandOps.lineWidth);
+    this.f32(width);
+    return this;
+  }
+  // a zero size removes the clip
+  clip(x = 0, y = 0, w = 0, h = 0) {
+    this.reserve(5);
+    this.u32(commandOps.clip);
+    for (const v of [x, y, w, h]) this.f32(v);
+    return this;
+  }
+  rect(x, y, w, h) {
+    this.reserve(5);
+    this.u32(commandOps.rect);
+    for (const v of [x, y, w, h]) this.f32(v);
+    return this;
+  }
+  line(x0, y0, x1, y1) {
+    this.reserve(5);
+    this.u32(commandOps.line);
+    for (const v of [x0, y0, x1, y1]) this.f32(v);
+    return this;
+  }
+  // points are [x0, y0, x1, y1, ...]
+  polyline(points) {
+    const count = Math.floor(points.length / 2);
+    this.reserve(2 + count * 2);
+    this.u32(commandOps.polyline);
+    this.u32(count);
+    for (let i = 0; i < count * 2; i++) this.f32(points[i]);
+    return this;
+  }
+  // angles in radians clockwise from +x, filled arcs are pie slices
+  arc(cx, cy, radius, start, end, fill = false) {
+    this.reserve(7);
+    this.u32(commandOps.arc);
+    for (const v of [cx, cy, radius, start, end]) this.f32(v);
+    this.u32(fill ? 1 : 0);
+    return this;
+  }
+  text(text, x, y, options = {}) {
+    const {
+      font = "12px sans-serif",
+      align = "left",
+      baseline = "alphabetic",
+    } = options;
+    const entry = getTextFont(font);
+    const codepoints = toCodepoints(text);
+    let pending = this.glyphs.get(entry);
+    if (!pending) this.glyphs.set(entry, (pending = new Set()));
+    for (const codepoint of codepoints) pending.add(codepoint);
+    this.reserve(7 + codepoints.length);
+    this.u32(commandOps.text);
+    this.f32(x);
+    this.f32(y);
+    // the font id is only known once the font reached the atlas
+    this.fontSlots.push([this.length, entry]);
+    this.u32(0);
+    this.u32(textAligns[align] ?? 0);
+    this.u32(textBaselines[baseline] ?? 0);
+    this.u32(codepoints.length);
+    for (const codepoint of codepoints) this.u32(codepoint);
+    return this;
+  }
+}
+
+// width of the text in pixels from cached advances, without kerning
+export const measureText = (text, font = "12px sans-serif") => {
+  const entry = getTextFont(font);
+  let width = 0;
+  for (const char of String(text))
+    width += getGlyph(entry, char.codePointAt(0)).advance;
+  return width;
+};
+
+// One timer drives every managed window, render_all draws the ones that
+// changed since their last frame and polls events once per tick.
+const scheduler = {
+  windows: new Set(),
+  timer: null,
+  interval: 0,
+};
+function restartScheduler() {
+  if (scheduler.windows.size === 0) {
+    if (scheduler.timer) clearInterval(scheduler.timer);
+    scheduler.timer = null;
+    return;
+  }
+  let interval = Infinity;
+  for (const window of scheduler.windows)
+    interval = Math.min(interval, window.tick_interval);
+  if (scheduler.timer && interval === scheduler.interval) return;
+  if (scheduler.timer) clearInterval(scheduler.timer);
+  scheduler.interval = interval;
+  scheduler.timer = setInterval(() => {
+    for (const window of scheduler.windows) {
+      if (window.should_close) window.close();
+    }
+    if (scheduler.windows.size) lib.symbols.render_all();
+  }, interval);
+}
+
 class Window {
   constructor(title, w, h, managed = true) {
     this.title = title;
@@ -186,18 +947,18 @@ class Window {
     this.h = h;
     this.managed = managed;
     this.created = false;
-    this.interval = null;
     this.should_close = false;
     this.tick_interval = 50;
     this.color_type = "rgba";
+    this.layer_types = {};
+    this.panel_types = {};
   }
   setCloseCallback(cb) {
     this.close_calle = cb;
   }
   close() {
     if (!this.created) return;
-    if (this.interval) clearInterval(this.interval);
-    this.interval = null;
+    if (scheduler.windows.delete(this)) restartScheduler();
     lib.symbols.dispose_instance(this.instance);
     this.instance = null;
     this.closeCallback.close();
@@ -210,6 +971,8 @@ class Window {
       this.internalMouseButtonCallback.close();
     if (this.internalWindowFocusCallback)
       this.internalWindowFocusCallback.close();
+    if (this.internalPanelMouseCallback)
+      this.internalPanelMouseCallback.close();
     this.created = false;
     if (this.close_calle) this.close_calle();
   }
@@ -217,22 +980,240 @@ class Window {
     if (!this.created) return;
     lib.symbols.set_clear_color(this.instance, r, g, b);
   }
+  setColorType(type) {
+    if (type === this.color_type) return true;
+    const lower = type.toLowerCase();
+    if (!(lower in pixelSizes)) return false;
+    lib.symbols.set_buffer_color_type(
+      this.instance,
+      isBun ? Buffer.from(lower + "\0", "utf-8") : lower,
+    );
+    this.color_type = lower;
+    return true;
+  }
   updateBuffer(buffer, w, h, type = "rgba") {
     if (!this.created) return;
-    if (type !== this.color_type) {
-      const lower = type.toLowerCase();
-      if (lower === "rgb" || lower === "rgba" || lower === "bgra") {
-        lib.symbols.set_buffer_color_type(
-          this.instance,
-          isBun ? Buffer.from(lower + "\0", "utf-8") : lower,
-        );
-        this.color_type = lower;
-      } else {
-        return;
-      }
-    }
+    if (!this.setColorType(type)) return;
     lib.symbols.move_buffer_to_image(this.instance, ptr(buffer), w, h);
-    this.force_render();
+    this.requestRender();
+  }
+  // shows the w * h pixels at x, y of a buffer whose rows are stride pixels
+  // long, crops and mosaic tiles need no copy in JS
+  updateBufferRegion(buffer, stride, x, y, w, h, type = "rgba") {
+    if (!this.created) return;
+    if (!this.setColorType(type)) return;
+    const end = ((y + h - 1) * stride + x + w) * pixelSizes[this.color_type];
+    if (w <= 0 || h <= 0 || x + w > stride || buffer.byteLength < end) return;
+    lib.symbols.move_buffer_region_to_image(
+      this.instance,
+      ptr(buffer),
+      stride,
+      x,
+      y,
+      w,
+      h,
+    );
+    this.requestRender();
+  }
+  // shows the [x, y, w, h] part of the buffer (in buffer pixels) scaled into
+  // the window, panning and zooming does not upload the buffer again
+  setView(x, y, w, h) {
+    if (!this.created) return;
+    lib.symbols.set_view(this.instance, x, y, w, h);
+    this.requestRender();
+  }
+  resetView() {
+    this.setView(0, 0, 0, 0);
+  }
+  // smoother minification when zoomed out of large buffers
+  setMipmaps(enabled) {
+    if (!this.created) return;
+    lib.symbols.set_mipmaps(this.instance, enabled ? 1 : 0);
+    this.requestRender();
+  }
+  // extra images composited over the same area as the buffer, layers with a
+  // negative z are drawn below it, layers that do not change are not uploaded
+  addLayer(z = 1) {
+    if (!this.created) return -1;
+    const id = lib.symbols.add_layer(this.instance, z);
+    if (id >= 0) this.layer_types[id] = "rgba";
+    return id;
+  }
+  removeLayer(id) {
+    if (!this.created) return;
+    lib.symbols.remove_layer(this.instance, id);
+    delete this.layer_types[id];
+  }
+  updateLayer(id, buffer, w, h, type = "rgba") {
+    if (!this.created || !(id in this.layer_types)) return;
+    const lower = type.toLowerCase();
+    if (!(lower in pixelSizes)) return;
+    if (this.layer_types[id] !== lower) {
+      lib.symbols.set_layer_color_type(
+        this.instance,
+        id,
+        isBun ? Buffer.from(lower + "\0", "utf-8") : lower,
+      );
+      this.layer_types[id] = lower;
+    }
+    if (buffer.byteLength < w * h * pixelSizes[lower]) return;
+    lib.symbols.update_layer(this.instance, id, ptr(buffer), w, h);
+  }
+  setLayerVisible(id, visible) {
+    if (!this.created) return;
+    lib.symbols.set_layer_visible(this.instance, id, visible ? 1 : 0);
+  }
+  setLayerZ(id, z) {
+    if (!this.created) return;
+    lib.symbols.set_layer_z(this.instance, id, z);
+  }
+  setLayerAlpha(id, alpha) {
+    if (!this.created) return;
+    lib.symbols.set_layer_alpha(this.instance, id, alpha);
+  }
+  // independent charts laid out in one window, drawn in one pass with a
+  // single swap, panels without a rect fill the grid in id order
+  addPanel() {
+    if (!this.created) return -1;
+    const id = lib.symbols.add_panel(this.instance);
+    if (id >= 0) this.panel_types[id] = "rgba";
+    return id;
+  }
+  removePanel(id) {
+    if (!this.created) return;
+    lib.symbols.remove_panel(this.instance, id);
+    delete this.panel_types[id];
+  }
+  updatePanel(id, buffer, w, h, type = "rgba") {
+    if (!this.created || !(id in this.panel_types)) return;
+    const lower = type.toLowerCase();
+    if (!(lower in pixelSizes)) return;
+    if (this.panel_types[id] !== lower) {
+      lib.symbols.set_panel_color_type(
+        this.instance,
+        id,
+        isBun ? Buffer.from(lower + "\0", "utf-8") : lower,
+      );
+      this.panel_types[id] = lower;
+    }
+    if (buffer.byteLength < w * h * pixelSizes[lower]) return;
+    lib.symbols.update_panel(this.instance, id, ptr(buffer), w, h);
+  }
+  // x, y, w, h are fractions of the window, a 0 size goes back to the grid
+  setPanelRect(id, x, y, w, h) {
+    if (!this.created) return;
+    lib.symbols.set_panel_rect(this.instance, id, x, y, w, h);
+  }
+  setPanelVisible(id, visible) {
+    if (!this.created) return;
+    lib.symbols.set_panel_visible(this.instance, id, visible ? 1 : 0);
+  }
+  // 0 columns or rows are picked from the panel count, gap is in pixels
+  setPanelGrid(cols = 0, rows = 0, gap = 0) {
+    if (!this.created) return;
+    lib.symbols.set_panel_grid(this.instance, cols, rows, gap);
+  }
+  setPanelMouseCallback(cb) {
+    if (this.panelMouseCallback || !this.created) return;
+    this.panelMouseCallback = cb;
+    this.internalPanelMouseCallback = JSCallback(
+      (instance, panel, x, y, button, action) => {
+        cb({ panel, x, y, button, action });
+        return true;
+      },
+      {
+        args: ["ptr", "i32", "f64", "f64", "i32", "i32"],
+        returns: "u8",
+      },
+    );
+    lib.symbols.set_panel_mouse_callback(
+      this.instance,
+      this.internalPanelMouseCallback,
+    );
+  }
+  // images of any size split into tiles, only visible tiles are uploaded,
+  // 0 width or height goes back to the normal buffer
+  setTiledImage(width, height, type = "rgba", tileSize = 512) {
+    if (!this.created) return;
+    if (!this.setColorType(type)) return;
+    lib.symbols.set_tiled_image(this.instance, width, height, tileSize);
+    // the tiles keep the type they were created with
+    this.tiled_type = width > 0 && height > 0 ? this.color_type : null;
+  }
+  // writes a w x h block of pixels at x, y
+  writeTiles(data, x, y, w, h) {
+    if (!this.created || !this.tiled_type) return;
+    if (data.byteLength < w * h * pixelSizes[this.tiled_type]) return;
+    lib.symbols.tiled_image_write(this.instance, ptr(data), x, y, w, h);
+  }
+  setTileBudget(megabytes) {
+    if (!this.created) return;
+    lib.symbols.set_tile_budget(this.instance, megabytes);
+  }
+  // the buffer becomes a ring of rows, pushRows only uploads the new rows
+  setWaterfall(width, rows, type = "rgba", newestOnTop = true) {
+    if (!this.created) return;
+    if (!this.setColorType(type)) return;
+    this.waterfall_width = width;
+    lib.symbols.set_waterfall(this.instance, width, rows, newestOnTop ? 1 : 0);
+    this.requestRender();
+  }
+  pushRows(rows) {
+    if (!this.created || !this.waterfall_width) return;
+    const rowSize = this.waterfall_width * pixelSizes[this.color_type];
+    const count = Math.floor(rows.byteLength / rowSize);
+    if (count === 0) return;
+    // rows are uploaded right away and shown on the next tick, rendering
+    // per push would tie the row rate to the swap interval
+    lib.symbols.waterfall_push_rows(this.instance, ptr(rows), count);
+  }
+
+  // colormap for "r32f" and "r16" buffers, colors are spread evenly over
+  // the scalar range
+  setColormap(colors) {
+    if (!this.created || !colors.length) return;
+    const lut = Buffer.alloc(colors.length * 4);
+    for (let i = 0; i < colors.length; i++) {
+      const [r, g, b, a = 255] = colors[i];
+      lut.set([r, g, b, a], i * 4);
+    }
+    lib.symbols.set_colormap(this.instance, ptr(lut), colors.length);
+    this.requestRender();
+  }
+  // colors of "indexed8" buffers starting at entry first, entries that were
+  // never set are a gray ramp, changing them does not upload the buffer again.
+  // false when the colors run past entry 255
+  setPalette(colors, first = 0) {
+    if (!this.created || !colors.length) return false;
+    const entries = Buffer.alloc(colors.length * 4);
+    for (let i = 0; i < colors.length; i++) {
+      const [r, g, b, a = 255] = colors[i];
+      entries.set([r, g, b, a], i * 4);
+    }
+    if (
+      lib.symbols.set_palette(this.instance, ptr(entries), first, colors.length)
+    )
+      return false;
+    this.requestRender();
+    return true;
+  }
+  // values outside [min, max] are clamped to the ends of the colormap,
+  // changing the range does not upload the buffer again
+  setScalarRange(min, max) {
+    if (!this.created) return;
+    lib.symbols.set_scalar_range(this.instance, min, max);
+    this.requestRender();
+  }
+
+  // maps level - window / 2 .. level + window / 2 to the full output range,
+  // for scalar buffers within the scalar range. (1, 0.5) shows the values
+  // unchanged, false for a window that is not positive
+  setWindowLevel(window, level) {
+    if (!this.created) return false;
+    if (lib.symbols.set_window_level(this.instance, window, level))
+      return false;
+    this.requestRender();
+    return true;
   }
 
   setKeyCallback(cb) {
@@ -308,7 +1289,7 @@ class Window {
   setMousePositionCallback(cb) {
     if (this.mousePositionCallback || !this.created) return;
     this.mousePositionCallback = cb;
-    this.internalMousePositionCallback = new JSCallback(
+    this.internalMousePositionCallback = JSCallback(
       (instance, x, y) => {
         cb(x, y);
         return true;
@@ -362,10 +1343,216 @@ class Window {
     );
   }
 
+  // GPU drawn polylines composited over the buffer, points are [x, y] pairs
+  // in the coordinate space given to setLineRange
+  addLineSeries(capacity = 65536) {
+    if (!this.created) return -1;
+    return lib.symbols.add_line_series(this.instance, capacity);
+  }
+  removeLineSeries(id) {
+    if (!this.created) return;
+    lib.symbols.remove_line_series(this.instance, id);
+  }
+  appendLineSeries(id, points) {
+    if (!this.created) return;
+    const data =
+      points instanceof Float32Array ? points : Float32Array.from(points);
+    if (data.length < 2) return;
+    lib.symbols.line_series_append(
+      this.instance,
+      id,
+      ptr(data),
+      Math.floor(data.length / 2),
+    );
+  }
+  clearLineSeries(id) {
+    if (!this.created) return;
+    lib.symbols.line_series_clear(this.instance, id);
+  }
+  setLineSeriesStyle(id, color = [0, 50, 200, 255], width = 2) {
+    if (!this.created) return;
+    const [r, g, b, a = 255] = color;
+    lib.symbols.line_series_style(this.instance, id, r, g, b, a, width);
+  }
+  setLineRange(xMin, xMax, yMin, yMax) {
+    if (!this.created) return;
+    lib.symbols.set_line_range(this.instance, xMin, xMax, yMin, yMax);
+  }
+  // plot area inside the buffer in buffer pixels, 0 width/height uses all of it
+  setLineArea(x, y, w, h) {
+    if (!this.created) return;
+    lib.symbols.set_line_area(this.instance, x, y, w, h);
+  }
+
+  // GPU drawn points sharing the line range and area, points are
+  // [x, y, size, colorIndex] with size in pixels and up to 16 palette colors
+  addScatterSet(capacity = 1 << 20) {
+    if (!this.created) return -1;
+    return lib.symbols.add_scatter_set(this.instance, capacity);
+  }
+  removeScatterSet(id) {
+    if (!this.created) return;
+    lib.symbols.remove_scatter_set(this.instance, id);
+  }
+  appendScatter(id, points) {
+    if (!this.created) return;
+    const data =
+      points instanceof Float32Array ? points : Float32Array.from(points);
+    if (data.length < 4) return;
+    lib.symbols.scatter_append(
+      this.instance,
+      id,
+      ptr(data),
+      Math.floor(data.length / 4),
+    );
+  }
+  clearScatter(id) {
+    if (!this.created) return;
+    lib.symbols.scatter_clear(this.instance, id);
+  }
+  setScatterPalette(id, colors) {
+    if (!this.created || !colors.length) return;
+    const palette = Buffer.alloc(Math.min(colors.length, 16) * 4);
+    for (let i = 0; i < palette.length / 4; i++) {
+      const [r, g, b, a = 255] = colors[i];
+      palette.set([r, g, b, a], i * 4);
+    }
+    lib.symbols.scatter_set_palette(
+      this.instance,
+      id,
+      ptr(palette),
+      palette.length / 4,
+    );
+  }
+  // overplotted points are summed into a float target and shaded from
+  // palette[0] to palette[1], scale controls how fast it saturates
+  setScatterDensity(id, enabled, scale = 0) {
+    if (!this.created) return;
+    lib.symbols.scatter_set_density(this.instance, id, enabled ? 1 : 0, scale);
+  }
+
+  // text drawn from the shared glyph atlas, x/y are buffer pixels and follow
+  // the view, glyphs keep their size in window pixels
+  addText(text, x, y, options = {}) {
+    if (!this.created) return -1;
+    const id = lib.symbols.add_text(this.instance);
+    if (id >= 0 && !this.setText(id, text, x, y, options)) {
+      lib.symbols.remove_text(this.instance, id);
+      return -1;
+    }
+    return id;
+  }
+  // false when a glyph did not fit into the atlas, the text is left unchanged
+  setText(id, text, x, y, options = {}) {
+    if (!this.created) return false;
+    const {
+      font = "12px sans-serif",
+      color = [0, 0, 0, 255],
+      align = "left",
+      baseline = "alphabetic",
+    } = options;
+    const entry = getTextFont(font);
+    const codepoints = toCodepoints(text);
+    if (!uploadGlyphs(this, entry, codepoints)) return false;
+    lib.symbols.set_text(
+      this.instance,
+      id,
+      entry.id,
+      ptr(codepoints),
+      codepoints.length,
+      x,
+      y,
+      textAligns[align] ?? 0,
+      textBaselines[baseline] ?? 0,
+    );
+    const [r, g, b, a = 255] = color;
+    lib.symbols.set_text_style(this.instance, id, r, g, b, a);
+    return true;
+  }
+  setTextVisible(id, visible) {
+    if (!this.created) return;
+    lib.symbols.set_text_visible(this.instance, id, visible ? 1 : 0);
+  }
+  removeText(id) {
+    if (!this.created) return;
+    lib.symbols.remove_text(this.instance, id);
+  }
+
+  // decodes a whole CommandBuffer into the window buffer in one native call,
+  // false when its text did not fit into the glyph atlas
+  executeCommands(commands) {
+    if (!this.created) return false;
+    if (commands.length === 0) return true;
+    if (!prepareCommands(this, commands)) return false;
+    lib.symbols.execute_commands(
+      this.instance,
+      ptr(commands.bytes),
+      commands.length,
+    );
+    return true;
+  }
+
+  // retained nodes drawn into the window buffer, changing a node only redraws
+  // and uploads the area it covered before and after
+  setSceneBackground(r, g, b, a = 255) {
+    if (!this.created) return;
+    lib.symbols.set_scene_background(this.instance, r, g, b, a);
+  }
+  addSceneNode(commands = null, options = {}) {
+    if (!this.created) return -1;
+    const { z = 0, x = 0, y = 0 } = options;
+    const id = lib.symbols.add_scene_node(this.instance, z);
+    if (id < 0) return id;
+    if (x !== 0 || y !== 0)
+      lib.symbols.set_scene_node_offset(this.instance, id, x, y);
+    if (commands) this.setSceneNode(id, commands);
+    return id;
+  }
+  // the node keeps a copy, the CommandBuffer can be reset and reused
+  setSceneNode(id, commands) {
+    if (!this.created) return false;
+    if (!prepareCommands(this, commands)) return false;
+    lib.symbols.set_scene_node(
+      this.instance,
+      id,
+      commands.length ? ptr(commands.bytes) : null,
+      commands.length,
+    );
+    return true;
+  }
+  moveSceneNode(id, x, y) {
+    if (!this.created) return;
+    lib.symbols.set_scene_node_offset(this.instance, id, x, y);
+  }
+  setSceneNodeVisible(id, visible) {
+    if (!this.created) return;
+    lib.symbols.set_scene_node_visible(this.instance, id, visible ? 1 : 0);
+  }
+  setSceneNodeZ(id, z) {
+    if (!this.created) return;
+    lib.symbols.set_scene_node_z(this.instance, id, z);
+  }
+  removeSceneNode(id) {
+    if (!this.created) return;
+    lib.symbols.remove_scene_node(this.instance, id);
+  }
+  // pixels redrawn for the scene in the last frame
+  sceneDrawnPixels() {
+    if (!this.created) return 0;
+    return lib.symbols.get_scene_drawn_pixels(this.instance);
+  }
+
   force_render() {
     if (!this.created) return;
     lib.symbols.render_window(this.instance);
   }
+  // managed windows are drawn on the next scheduler tick, together with all
+  // other windows that changed, unmanaged ones right away
+  requestRender() {
+    if (!this.created) return;
+    if (this.managed) lib.symbols.request_render(this.instance);
+    else lib.symbols.render_window(this.instance);
+  }
   updateTitle(title) {
     this.title = title;
     const name_buffer = isBun ? Buffer.from(title + "\0", "utf-8") : title;
@@ -404,19 +1591,152 @@ class Window {
     );
     this.created = true;
     if (this.managed) {
-      this.interval = setInterval(() => {
-        if (this.should_close) {
-          this.close();
-          return;
-        }
-        lib.symbols.render_window(this.instance);
-      }, this.tick_interval);
+      scheduler.windows.add(this);
+      restartScheduler();
     } else {
       lib.symbols.set_is_managed(this.instance, 0);
     }
   }
 }
 
+// linked shader programs are cached on disk per driver, null restores the
+// default directory and "" disables the cache, call before creating windows
+export const setProgramCacheDir = (path) => {
+  if (path === null || path === undefined) {
+    lib.symbols.set_program_cache_dir(null);
+    return;
+  }
+  lib.symbols.set_program_cache_dir(
+    isBun ? Buffer.from(path + "\0", "utf-8") : path,
+  );
+};
+
+// initializes glfw and the shared context now and links the shaders on a
+// helper thread (in place on macOS and Windows), so the first window opens
+// without waiting for them
+export const prewarm = (threaded = true) => {
+  lib.symbols.prewarm(threaded ? 1 : 0);
+};
+
+// milliseconds spent in each startup step, 0 for steps that did not run yet
+export const startupTimings = () => {
+  const out = new Float64Array(7);
+  lib.symbols.get_startup_timings(ptr(out));
+  return {
+    dlopen: dlopenTime,
+    init: out[0],
+    shareContext: out[1],
+    glLoad: out[2],
+    programs: out[3],
+    firstWindow: out[4],
+    firstFrame: out[5],
+    uploadProbe: out[6],
+  };
+};
+
+// upload path picked for each byte format and the GB/s measured for the
+// direct path and its alternative, 0 until the first rgb/bgra upload or
+// prewarm ran the probe
+export const uploadStats = () => {
+  const out = new Float64Array(9);
+  lib.symbols.get_upload_stats(ptr(out));
+  const paths = ["direct", "expand", "swizzle"];
+  const format = (i, alternative) => ({
+    path: paths[out[i * 3]],
+    direct: out[i * 3 + 1],
+    [alternative]: out[i * 3 + 2],
+  });
+  return {
+    rgba: { path: "direct", direct: out[1] },
+    rgb: format(1, "expand"),
+    bgra: format(2, "swizzle"),
+  };
+};
+
+// bytes per pixel and the GL internal format, format and component type an
+// image type is uploaded with, null for unknown types
+export const imageTypeInfo = (type) => {
+  const out = new Int32Array(4);
+  if (lib.symbols.get_image_type_info(cString(type), ptr(out))) return null;
+  const [pixelSize, internalFormat, format, dataType] = out;
+  return { pixelSize, internalFormat, format, dataType };
+};
+
+// threads drawing command buffers and scenes into large buffers, including
+// the calling one, 0 uses every core
+export const setRasterThreads = (count = 0) => {
+  lib.symbols.set_thread_count(count);
+};
+export const rasterThreads = () => lib.symbols.get_thread_count();
+
+// Fixed capacity ring buffer of samples which can be scrolled into a window.
+export class Series {
+  constructor(capacity, channels = 1, type = Float64Array) {
+    this.capacity = capacity;
+    this.channels = channels;
+    this.type = type === Float32Array ? Float32Array : Float64Array;
+    this.store = lib.symbols.create_series_store(
+      capacity,
+      channels,
+      this.type === Float64Array ? 1 : 0,
+    );
+  }
+  // values are interleaved per sample: [s0c0, s0c1, s1c0, s1c1, ...]
+  append(values, timestamps = null) {
+    if (!this.store) return;
+    const data = values instanceof this.type ? values : this.type.from(values);
+    const count = Math.floor(data.length / this.channels);
+    if (count === 0) return;
+    const times =
+      timestamps === null
+        ? null
+        : timestamps instanceof Float64Array
+          ? timestamps
+          : Float64Array.from(timestamps);
+    if (times !== null && times.length < count) return;
+    lib.symbols.series_append(
+      this.store,
+      times === null ? null : ptr(times),
+      ptr(data),
+      count,
+    );
+  }
+  setColor(channel, r, g, b) {
+    if (!this.store) return;
+    lib.symbols.series_set_color(this.store, channel, r, g, b);
+  }
+  read(channel = 0, max = this.capacity) {
+    const values = new Float64Array(max);
+    const timestamps = new Float64Array(max);
+    if (!this.store) return { values: values.subarray(0, 0), timestamps };
+    const n = lib.symbols.series_read(
+      this.store,
+      channel,
+      max,
+      ptr(values),
+      ptr(timestamps),
+    );
+    return { values: values.subarray(0, n), timestamps: timestamps.subarray(0, n) };
+  }
+  // scrolls the window buffer left and draws only the newly completed columns
+  renderTo(window, yMin, yMax, samplesPerColumn = 1) {
+    if (!this.store || !window.created) return;
+    lib.symbols.series_render_scroll(
+      window.instance,
+      this.store,
+      yMin,
+      yMax,
+      samplesPerColumn,
+    );
+    window.requestRender();
+  }
+  dispose() {
+    if (!this.store) return;
+    lib.symbols.dispose_series_store(this.store);
+    this.store = null;
+  }
+}
+
 export const easyWindow = (title, buffer, w, h, type = "rgba", winCb = null) => {
   return new Promise((resolve) => {
     const window = new Window(title, w, h);
@@ -500,7 +1820,7 @@ export const plot = (
     ctx.moveTo(1, start_y + 1);
     ctx.lineTo(w, start_y + 1);
     ctx.stroke();
-    const { width } = ctx.measureText(marking[1]);
+    const width = measureText(marking[1], "14px Arial");
     if (width > 20 && width - 20 > l_offset) l_offset = width - 20;
   }
   const work_width = w - (40 + l_offset);
@@ -535,8 +1855,7 @@ export const plot = (
 
   ctx.font = "14px Arial";
   ctx.fillStyle = `rgb(50, 50, 50)`;
-  let text_len = ctx.measureText(name);
-  const start = w / 2 - text_len.width / 2;
+  const start = w / 2 - measureText(name, "14px Arial") / 2;
   ctx.fillText(name, start, work_height + 30);
   return { canvas, w, h };
 };
@@ -633,8 +1952,7 @@ export const graph = (
       ctx.font = "14px Arial";
       ctx.fillStyle = color;
       ctx.fillText(name, name_offset, work_height + 30);
-      const text_len = ctx.measureText(name);
-      name_offset += text_len.width + 10;
+      name_offset += measureText(name, "14px Arial") + 10;
     }
   }
   return { canvas, w, h };
@@ -693,8 +2011,7 @@ export const pie = (
 
   ctx.font = "14px Arial";
   ctx.fillStyle = `rgb(50, 50, 50)`;
-  let text_len = ctx.measureText(name);
-  const start = w / 2 - text_len.width / 2;
+  const start = w / 2 - measureText(name, "14px Arial") / 2;
   ctx.fillText(name, start, work_height + 30);
   return { canvas, w, h };
 };
@@ -774,7 +2091,107 @@ export const iterativeWindow = (
   });
 };
 
-export const autoMap = (input) => {
+const rangeSymbols = (input) => {
+  if (input instanceof Float32Array)
+    return [lib.symbols.range_f32, lib.symbols.map_range_f32];
+  if (input instanceof Float64Array)
+    return [lib.symbols.range_f64, lib.symbols.map_range_f64];
+  return null;
+};
+
+const tickMarkers = (lowest, highest, count, mapped) => {
+  const ticks = new Float64Array(count * 2 + 2);
+  const found = lib.symbols.nice_ticks(
+    lowest,
+    highest,
+    count,
+    ptr(ticks),
+    ticks.length,
+  );
+  const span = highest - lowest;
+  const base = mapped ? lowest : 0;
+  const scale = mapped ? span : highest;
+  const lines = [];
+  for (let i = 0; i < found; i++) {
+    const p = scale === 0 ? 0 : (ticks[i] - base) / scale;
+    if (p < -1e-9 || p > 1 + 1e-9) continue;
+    lines.push([p, `${ticks[i].toFixed(2)}`]);
+  }
+  return lines;
+};
+
+// Streaming min/max and normalisation over Float32Array/Float64Array chunks.
+export class RangeMapper {
+  constructor() {
+    this.state = new Float64Array([Infinity, -Infinity]);
+  }
+  get lowest() {
+    return this.state[0];
+  }
+  get highest() {
+    return this.state[1];
+  }
+  reset() {
+    this.state[0] = Infinity;
+    this.state[1] = -Infinity;
+  }
+  observe(chunk) {
+    const symbols = rangeSymbols(chunk);
+    if (!symbols) return;
+    symbols[0](ptr(chunk), chunk.length, ptr(this.state));
+  }
+  // maps chunk from [lowest, highest] onto [0, 1] into out (in place when
+  // omitted), the chunk is observed in the same pass.
+  map(chunk, lowest, highest, out = chunk) {
+    const symbols = rangeSymbols(chunk);
+    if (!symbols || out.constructor !== chunk.constructor) return null;
+    symbols[1](
+      ptr(chunk),
+      ptr(out),
+      Math.min(chunk.length, out.length),
+      lowest,
+      highest,
+      ptr(this.state),
+    );
+    return out;
+  }
+}
+
+const autoMapTyped = (input, options) => {
+  const { out = null, inPlace = false, range = "zero", ticks = 0 } = options;
+  const symbols = rangeSymbols(input);
+  const state = new Float64Array([Infinity, -Infinity]);
+  symbols[0](ptr(input), input.length, ptr(state));
+  const [lowest, highest] = state;
+  if (lowest > highest) return [inPlace ? input : new input.constructor(0), []];
+  const mapped = range === "minmax";
+  const target = inPlace
+    ? input
+    : out && out.constructor === input.constructor && out.length >= input.length
+      ? out
+      : new input.constructor(input.length);
+  symbols[1](
+    ptr(input),
+    ptr(target),
+    input.length,
+    mapped ? lowest : 0,
+    highest,
+    null,
+  );
+  if (ticks > 0) return [target, tickMarkers(lowest, highest, ticks, mapped)];
+  const from = mapped ? lowest : 0;
+  const lines = [
+    [1, `${highest.toFixed(2)}`],
+    [0, `${from.toFixed(2)}`],
+  ];
+  for (const n of [0.25, 0.5, 0.75]) {
+    lines.push([n, `${(from + (highest - from) * n).toFixed(2)}`]);
+  }
+  return [target, lines];
+};
+
+export const autoMap = (input, options = {}) => {
+  if (rangeSymbols(input)) return autoMapTyped(input, options);
   let highest = null;
   let lowest = null;
   for (const number of input) {
@@ -794,4 +2211,6 @@ export const autoMap = (input) => {
   }
   return [out, lines];
 };
+if (process.env.BUN_UI_PREWARM) prewarm(process.env.BUN_UI_PREWARM !== "sync");
+
 export default Window;
@@ -0,0 +1,283 @@
+#include "automap.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUTOMAP_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AUTOMAP_NEON
+#endif
+
+static void range_merge(double *state, double lowest, double highest) {
+  if (lowest < state[0])
+    state[0] = lowest;
+  if (highest > state[1])
+    state[1] = highest;
+}
+
+/*
+ * The SIMD loops keep the accumulator as the second operand of min/max, which
+ * makes a NaN lane in the input fall back to the accumulator.
+ */
+static uint32_t range_f32_simd(const float *in, uint32_t len, float *lowest,
+                               float *highest) {
+  uint32_t i = 0;
+#if defined(AUTOMAP_SSE2)
+  if (len < 8)
+    return 0;
+  __m128 lo0 = _mm_set1_ps(*lowest), lo1 = lo0;
+  __m128 hi0 = _mm_set1_ps(*highest), hi1 = hi0;
+  for (; i + 8 <= len; i += 8) {
+    __m128 a = _mm_loadu_ps(in + i);
+    __m128 b = _mm_loadu_ps(in + i + 4);
+    lo0 = _mm_min_ps(a, lo0);
+    hi0 = _mm_max_ps(a, hi0);
+    lo1 = _mm_min_ps(b, lo1);
+    hi1 = _mm_max_ps(b, hi1);
+  }
+  lo0 = _mm_min_ps(lo0, lo1);
+  hi0 = _mm_max_ps(hi0, hi1);
+  lo0 = _mm_min_ps(lo0, _mm_shuffle_ps(lo0, lo0, _MM_SHUFFLE(1, 0, 3, 2)));
+  hi0 = _mm_max_ps(hi0, _mm_shuffle_ps(hi0, hi0, _MM_SHUFFLE(1, 0, 3, 2)));
+  lo0 = _mm_min_ps(lo0, _mm_shuffle_ps(lo0, lo0, _MM_SHUFFLE(2, 3, 0, 1)));
+  hi0 = _mm_max_ps(hi0, _mm_shuffle_ps(hi0, hi0, _MM_SHUFFLE(2, 3, 0, 1)));
+  *lowest = _mm_cvtss_f32(lo0);
+  *highest = _mm_cvtss_f32(hi0);
+#elif defined(AUTOMAP_NEON)
+  if (len < 8)
+    return 0;
+  float32x4_t lo0 = vdupq_n_f32(*lowest), lo1 = lo0;
+  float32x4_t hi0 = vdupq_n_f32(*highest), hi1 = hi0;
+  for (; i + 8 <= len; i += 8) {
+    float32x4_t a = vld1q_f32(in + i);
+    float32x4_t b = vld1q_f32(in + i + 4);
+    lo0 = vminnmq_f32(a, lo0);
+    hi0 = vmaxnmq_f32(a, hi0);
+    lo1 = vminnmq_f32(b, lo1);
+    hi1 = vmaxnmq_f32(b, hi1);
+  }
+  *lowest = vminnmvq_f32(vminnmq_f32(lo0, lo1));
+  *highest = vmaxnmvq_f32(vmaxnmq_f32(hi0, hi1));
+#endif
+  return i;
+}
+
+static uint32_t range_f64_simd(const double *in, uint32_t len, double *lowest,
+                               double *highest) {
+  uint32_t i = 0;
+#if defined(AUTOMAP_SSE2)
+  if (len < 4)
+    return 0;
+  __m128d lo0 = _mm_set1_pd(*lowest), lo1 = lo0;
+  __m128d hi0 = _mm_set1_pd(*highest), hi1 = hi0;
+  for (; i + 4 <= len; i += 4) {
+    __m128d a = _mm_loadu_pd(in + i);
+    __m128d b = _mm_loadu_pd(in + i + 2);
+    lo0 = _mm_min_pd(a, lo0);
+    hi0 = _mm_max_pd(a, hi0);
+    lo1 = _mm_min_pd(b, lo1);
+    hi1 = _mm_max_pd(b, hi1);
+  }
+  lo0 = _mm_min_pd(lo0, lo1);
+  hi0 = _mm_max_pd(hi0, hi1);
+  lo0 = _mm_min_sd(lo0, _mm_unpackhi_pd(lo0, lo0));
+  hi0 = _mm_max_sd(hi0, _mm_unpackhi_pd(hi0, hi0));
+  *lowest = _mm_cvtsd_f64(lo0);
+  *highest = _mm_cvtsd_f64(hi0);
+#elif defined(AUTOMAP_NEON)
+  if (len < 4)
+    return 0;
+  float64x2_t lo0 = vdupq_n_f64(*lowest), lo1 = lo0;
+  float64x2_t hi0 = vdupq_n_f64(*highest), hi1 = hi0;
+  for (; i + 4 <= len; i += 4) {
+    float64x2_t a = vld1q_f64(in + i);
+    float64x2_t b = vld1q_f64(in + i + 2);
+    lo0 = vminnmq_f64(a, lo0);
+    hi0 = vmaxnmq_f64(a, hi0);
+    lo1 = vminnmq_f64(b, lo1);
+    hi1 = vmaxnmq_f64(b, hi1);
+  }
+  *lowest = vminnmvq_f64(vminnmq_f64(lo0, lo1));
+  *highest = vmaxnmvq_f64(vmaxnmq_f64(hi0, hi1));
+#endif
+  return i;
+}
+
+uint8_t range_f32(const float *in, uint32_t len, double *state) {
+  float lowest = INFINITY, highest = -INFINITY;
+  uint32_t i = range_f32_simd(in, len, &lowest, &highest);
+  for (; i < len; i++) {
+    if (in[i] < lowest)
+      lowest = in[i];
+    if (in[i] > highest)
+      highest = in[i];
+  }
+  range_merge(state, lowest, highest);
+  return 0;
+}
+
+uint8_t range_f64(const double *in, uint32_t len, double *state) {
+  double lowest = INFINITY, highest = -INFINITY;
+  uint32_t i = range_f64_simd(in, len, &lowest, &highest);
+  for (; i < len; i++) {
+    if (in[i] < lowest)
+      lowest = in[i];
+    if (in[i] > highest)
+      highest = in[i];
+  }
+  range_merge(state, lowest, highest);
+  return 0;
+}
+
+uint8_t map_range_f32(const float *in, float *out, uint32_t len, double lowest,
+                      double highest, double *state) {
+  const float scale =
+      highest != lowest ? (float)(1.0 / (highest - lowest)) : 0.0f;
+  const float base = (float)lowest;
+  float lo = INFINITY, hi = -INFINITY;
+  uint32_t i = 0;
+#if defined(AUTOMAP_SSE2)
+  __m128 v_scale = _mm_set1_ps(scale);
+  __m128 v_base = _mm_set1_ps(base);
+  __m128 v_lo = _mm_set1_ps(lo);
+  __m128 v_hi = _mm_set1_ps(hi);
+  for (; i + 4 <= len; i += 4) {
+    __m128 a = _mm_loadu_ps(in + i);
+    v_lo = _mm_min_ps(a, v_lo);
+    v_hi = _mm_max_ps(a, v_hi);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_sub_ps(a, v_base), v_scale));
+  }
+  v_lo = _mm_min_ps(v_lo, _mm_shuffle_ps(v_lo, v_lo, _MM_SHUFFLE(1, 0, 3, 2)));
+  v_hi = _mm_max_ps(v_hi, _mm_shuffle_ps(v_hi, v_hi, _MM_SHUFFLE(1, 0, 3, 2)));
+  v_lo = _mm_min_ps(v_lo, _mm_shuffle_ps(v_lo, v_lo, _MM_SHUFFLE(2, 3, 0, 1)));
+  v_hi = _mm_max_ps(v_hi, _mm_shuffle_ps(v_hi, v_hi, _MM_SHUFFLE(2, 3, 0, 1)));
+  lo = _mm_cvtss_f32(v_lo);
+  hi = _mm_cvtss_f32(v_hi);
+#elif defined(AUTOMAP_NEON)
+  float32x4_t v_scale = vdupq_n_f32(scale);
+  float32x4_t v_base = vdupq_n_f32(base);
+  float32x4_t v_lo = vdupq_n_f32(lo);
+  float32x4_t v_hi = vdupq_n_f32(hi);
+  for (; i + 4 <= len; i += 4) {
+    float32x4_t a = vld1q_f32(in + i);
+    v_lo = vminnmq_f32(a, v_lo);
+    v_hi = vmaxnmq_f32(a, v_hi);
+    vst1q_f32(out + i, vmulq_f32(vsubq_f32(a, v_base), v_scale));
+  }
+  lo = vminnmvq_f32(v_lo);
+  hi = vmaxnmvq_f32(v_hi);
+#endif
+  for (; i < len; i++) {
+    float v = in[i];
+    if (v < lo)
+      lo = v;
+    if (v > hi)
+      hi = v;
+    out[i] = (v - base) * scale;
+  }
+  if (state)
+    range_merge(state, lo, hi);
+  return 0;
+}
+
+uint8_t map_range_f64(const double *in, double *out, uint32_t len,
+                      double lowest, double highest, double *state) {
+  const double scale = highest != lowest ? 1.0 / (highest - lowest) : 0.0;
+  double lo = INFINITY, hi = -INFINITY;
+  uint32_t i = 0;
+#if defined(AUTOMAP_SSE2)
+  __m128d v_scale = _mm_set1_pd(scale);
+  __m128d v_base = _mm_set1_pd(lowest);
+  __m128d v_lo = _mm_set1_pd(lo);
+  __m128d v_hi = _mm_set1_pd(hi);
+  for (; i + 2 <= len; i += 2) {
+    __m128d a = _mm_loadu_pd(in + i);
+    v_lo = _mm_min_pd(a, v_lo);
+    v_hi = _mm_max_pd(a, v_hi);
+    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_sub_pd(a, v_base), v_scale));
+  }
+  v_lo = _mm_min_sd(v_lo, _mm_unpackhi_pd(v_lo, v_lo));
+  v_hi = _mm_max_sd(v_hi, _mm_unpackhi_pd(v_hi, v_hi));
+  lo = _mm_cvtsd_f64(v_lo);
+  hi = _mm_cvtsd_f64(v_hi);
+#elif defined(AUTOMAP_NEON)
+  float64x2_t v_scale = vdupq_n_f64(scale);
+  float64x2_t v_base = vdupq_n_f64(lowest);
+  float64x2_t v_lo = vdupq_n_f64(lo);
+  float64x2_t v_hi = vdupq_n_f64(hi);
+  for (; i + 2 <= len; i += 2) {
+    float64x2_t a = vld1q_f64(in + i);
+    v_lo = vminnmq_f64(a, v_lo);
+    v_hi = vmaxnmq_f64(a, v_hi);
+    vst1q_f64(out + i, vmulq_f64(vsubq_f64(a, v_base), v_scale));
+  }
+  lo = vminnmvq_f64(v_lo);
+  hi = vmaxnmvq_f64(v_hi);
+#endif
+  for (; i < len; i++) {
+    double v = in[i];
+    if (v < lo)
+      lo = v;
+    if (v > hi)
+      hi = v;
+    out[i] = (v - lowest) * scale;
+  }
+  if (state)
+    range_merge(state, lo, hi);
+  return 0;
+}
+
+static double nice_number(double v, uint8_t round_result) {
+  double exponent = floor(log10(v));
+  double fraction = v / pow(10, exponent);
+  double nice;
+  if (round_result) {
+    if (fraction < 1.5)
+      nice = 1;
+    else if (fraction < 3)
+      nice = 2;
+    else if (fraction < 7)
+      nice = 5;
+    else
+      nice = 10;
+  } else {
+    if (fraction <= 1)
+      nice = 1;
+    else if (fraction <= 2)
+      nice = 2;
+    else if (fraction <= 5)
+      nice = 5;
+    else
+      nice = 10;
+  }
+  return nice * pow(10, exponent);
+}
+
+uint32_t nice_ticks(double lowest, double highest, uint32_t target, double *out,
+                    uint32_t out_len) {
+  if (out_len == 0 || !isfinite(lowest) || !isfinite(highest) ||
+      highest < lowest)
+    return 0;
+  if (highest == lowest) {
+    out[0] = lowest;
+    return 1;
+  }
+  if (target < 2)
+    target = 2;
+  double range = nice_number(highest - lowest, 0);
+  double step = nice_number(range / (target - 1), 1);
+  double start = floor(lowest / step) * step;
+  double end = ceil(highest / step) * step;
+  uint32_t count = 0;
+  for (uint32_t i = 0; count < out_len; i++) {
+    double v = start + step * i;
+    if (v > end + step * 0.5)
+      break;
+    // avoid printing -0 or 1e-17 for the zero tick
+    if (fabs(v) < step * 1e-9)
+      v = 0;
+    out[count++] = v;
+  }
+  return count;
+}
@@ -0,0 +1,39 @@
+#ifndef AUTOMAP_H
+#define AUTOMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * range_* functions accumulate into state[0] (lowest) and state[1] (highest),
+ * so a series can be fed in chunks. A fresh state is {INFINITY, -INFINITY}.
+ * NaN samples are skipped.
+ */
+uint8_t range_f32(const float *in, uint32_t len, double *state);
+uint8_t range_f64(const double *in, uint32_t len, double *state);
+
+/*
+ * Maps [lowest, highest] onto [0, 1]. in and out may be the same buffer.
+ * When state is not NULL the min/max of the input is accumulated in the
+ * same pass.
+ */
+uint8_t map_range_f32(const float *in, float *out, uint32_t len, double lowest,
+                      double highest, double *state);
+uint8_t map_range_f64(const double *in, double *out, uint32_t len,
+                      double lowest, double highest, double *state);
+
+/*
+ * Writes up to out_len "nice" (1, 2, 5 * 10^n) tick values covering
+ * [lowest, highest] to out and returns how many were written.
+ */
+uint32_t nice_ticks(double lowest, double highest, uint32_t target, double *out,
+                    uint32_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,24 +1,44 @@
 
 #include "bun-ui.h"
+#include "tiled.h"
+#include "panel.h"
+#include "program.h"
+#include "startup.h"
+#include "text.h"
+#include "scene.h"
+#include "upload.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
 size_t g_init = 0;
-size_t loaded_glad = 0;
 List g_list;
 
+// viridis, used for scalar images until set_colormap is called
+static const uint8_t default_colormap[] = {
+    68,  1,   84,  255, 70,  50,  126, 255, 54,  92,  141, 255,
+    39,  127, 142, 255, 31,  161, 135, 255, 74,  193, 109, 255,
+    160, 218, 57,  255, 253, 231, 37,  255};
+// shared by all windows that did not set their own colormap
+static GLuint g_default_colormap = 0;
+// gray ramp for INDEXED8 images of windows without their own palette
+static GLuint g_default_palette = 0;
+// start of the first create_window, for the time to the first frame
+static double g_first_window_start = 0;
+
 int bun_ui_init() {
   if (g_init == 1)
     return 0;
   g_list.size = 0;
   g_list.head = NULL;
   g_list.tail = NULL;
+  double start = startup_now();
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwSwapInterval(1);
+  startup_record(STARTUP_INIT, start);
 
   g_init = 1;
   return 0;
@@ -36,11 +56,85 @@ GLuint simple_compile_shader(GLuint type, const char *content) {
   }
   return id;
 }
+// the image shown in the window, tiled images replace the render buffer
+static Image *content_image(UiInstance *instance) {
+  if (instance->tiled)
+    return &instance->tiled->source;
+  return &instance->render_buffer;
+}
+
+// the part of the content image shown in the window, in buffer pixels
+static Vec4f image_view(UiInstance *instance) {
+  Image *image = content_image(instance);
+  Vec4f view = instance->view;
+  if (view.z <= 0 || view.w <= 0)
+    return vec4f(0, 0, image->w, image->h);
+  return view;
+}
+
+static Shader *create_image_shader(const char *fragment_content) {
+  ShaderVar vars[2] = {{2, sizeof(SimpleShaderEntry), GL_FLOAT,
+                        (void *)offsetof(SimpleShaderEntry, pos)},
+                       {2, sizeof(SimpleShaderEntry), GL_FLOAT,
+                        (void *)offsetof(SimpleShaderEntry, size)}};
+  return create_shader(IMAGE_SHADER_VERT, fragment_content,
+                       sizeof(SimpleShaderEntry), vars, 2);
+}
+
+static void upload_colormap(GLuint *texture, const uint8_t *rgba,
+                            uint32_t count) {
+  if (!*texture)
+    glGenTextures(1, texture);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, *texture);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, count, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, rgba);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+// the storage always has 256 entries, later updates only touch count of them
+static void upload_palette(GLuint *texture, const uint8_t *rgba,
+                           uint32_t first, uint32_t count) {
+  glActiveTexture(GL_TEXTURE1);
+  if (!*texture) {
+    uint8_t ramp[256 * 4];
+    for (uint32_t i = 0; i < 256; i++) {
+      ramp[i * 4] = ramp[i * 4 + 1] = ramp[i * 4 + 2] = i;
+      ramp[i * 4 + 3] = 255;
+    }
+    glGenTextures(1, texture);
+    glBindTexture(GL_TEXTURE_1D, *texture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, 256, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, ramp);
+  } else {
+    glBindTexture(GL_TEXTURE_1D, *texture);
+  }
+  if (count) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, first, count, GL_RGBA,
+                    GL_UNSIGNED_BYTE, rgba);
+  }
+  glActiveTexture(GL_TEXTURE0);
+}
+
 UiInstance *create_window(char *window_title, size_t buffer_w, size_t buffer_h,
                           size_t window_width, size_t window_height,
                           void *close_callback) {
+  double start = startup_now();
+  if (!g_first_window_start)
+    g_first_window_start = start;
   if (bun_ui_init())
     return NULL;
+  // a threaded prewarm owns the share context until it is done
+  prewarm_wait();
   UiInstance *instance = calloc(1, sizeof(UiInstance));
   instance->close_callback = close_callback;
   instance->window_width = window_width;
@@ -49,33 +143,35 @@ UiInstance *create_window(char *window_title, size_t buffer_w, size_t buffer_h,
   instance->clear_color = clear_color;
   instance->render_buffer.type = RGBA;
   instance->is_managed = 1;
+  instance->line_range = vec4f(0, 0, 1, 1);
+  instance->scalar_min = 0;
+  instance->scalar_max = 1;
+  instance->contrast_window = 1;
+  instance->contrast_level = 0.5f;
+  instance->needs_render = 1;
+  instance->swap_interval = -1;
 
-  instance->window =
-      glfwCreateWindow(window_width, window_height, window_title, NULL, NULL);
+  // programs and immutable textures are created once for all windows
+  GLFWwindow *share = share_window();
+  instance->window = glfwCreateWindow(window_width, window_height,
+                                      window_title, NULL, share);
   glfwMakeContextCurrent(instance->window);
   float xscale, yscale;
   glfwGetWindowContentScale(instance->window, &xscale, &yscale);
   instance->window_width *= xscale;
   instance->window_height *= yscale;
-  if (loaded_glad == 0) {
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-      return NULL;
-    }
-    loaded_glad = 1;
-  }
+  if (load_gl())
+    return NULL;
   glEnable(GL_CULL_FACE);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  ShaderVar vars[2] = {{2, sizeof(SimpleShaderEntry), GL_FLOAT,
-                        (void *)offsetof(SimpleShaderEntry, pos)},
-                       {2, sizeof(SimpleShaderEntry), GL_FLOAT,
-                        (void *)offsetof(SimpleShaderEntry, size)}};
-  instance->shader =
-      create_shader(IMAGE_SHADER_VERT, IMAGE_SHADER_FRAG, 16, vars, 2);
+  instance->shader = create_image_shader(IMAGE_SHADER_FRAG);
   image_buffer_resize(&(instance->render_buffer), buffer_w, buffer_h);
   allocate_texture(&(instance->render_buffer));
   instance->list_entry = list_append(&g_list, instance);
+  glfwSetWindowRefreshCallback(instance->window, window_refresh_callback);
   glfwPollEvents();
+  startup_record(STARTUP_FIRST_WINDOW, start);
   return instance;
 }
 
@@ -83,25 +179,131 @@ uint8_t set_clear_color(UiInstance *instance, uint8_t r, uint8_t g, uint8_t b) {
 
   RgbaColor clear_color = {.r = r, .g = g, .b = b, .a = 255};
   instance->clear_color = clear_color;
+  instance->needs_render = 1;
   return 0;
 }
 
-uint8_t render_window(UiInstance *instance) {
+/*
+ * Binds the shader for the given image type and sets everything but the
+ * view, scroll defaults to no scrolling.
+ */
+Shader *use_image_shader(UiInstance *instance, Image *image, float alpha) {
+  Shader *shader = instance->shader;
+  GLuint colormap = instance->colormap_texture;
+  if (image_is_scalar(image)) {
+    if (!colormap) {
+      if (!g_default_colormap)
+        upload_colormap(&g_default_colormap, default_colormap,
+                        sizeof(default_colormap) / 4);
+      colormap = g_default_colormap;
+    }
+    if (image->type == R16UI) {
+      if (!instance->scalar_uint_shader)
+        instance->scalar_uint_shader =
+            create_image_shader(SCALAR_UINT_SHADER_FRAG);
+      shader = instance->scalar_uint_shader;
+    } else {
+      if (!instance->scalar_shader)
+        instance->scalar_shader = create_image_shader(SCALAR_SHADER_FRAG);
+      shader = instance->scalar_shader;
+    }
+  } else if (image->type == INDEXED8) {
+    if (!instance->indexed_shader)
+      instance->indexed_shader = create_image_shader(INDEXED_SHADER_FRAG);
+    shader = instance->indexed_shader;
+  }
+  shader_use(shader);
+  shader_set2f(shader, "resolution", (float)instance->window_width,
+               (float)instance->window_height);
+  shader_set2f(shader, "scroll", 1, 0);
+  shader_set1f(shader, "alpha", alpha);
+  if (shader != instance->indexed_shader) {
+    // layers and panels are overlays and keep their colors, palette colors
+    // are categories without a contrast
+    const uint8_t content = image == content_image(instance);
+    shader_set1f(shader, "window", content ? instance->contrast_window : 1.0f);
+    shader_set1f(shader, "level", content ? instance->contrast_level : 0.5f);
+  }
+  if (shader == instance->scalar_shader ||
+      shader == instance->scalar_uint_shader) {
+    // r16 is sampled normalized, the range is given in raw values
+    shader_set1f(shader, "value_scale", image->type == R16 ? 65535.0f : 1.0f);
+    shader_set2f(shader, "value_range", instance->scalar_min,
+                 instance->scalar_max);
+    shader_set1i(shader, "img", 0);
+    shader_set1i(shader, "colormap", 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, colormap);
+    glActiveTexture(GL_TEXTURE0);
+  }
+  if (shader == instance->indexed_shader) {
+    GLuint palette = instance->palette_texture;
+    if (!palette) {
+      if (!g_default_palette)
+        upload_palette(&g_default_palette, NULL, 0, 0);
+      palette = g_default_palette;
+    }
+    shader_set1i(shader, "img", 0);
+    shader_set1i(shader, "palette", 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, palette);
+    glActiveTexture(GL_TEXTURE0);
+  }
+  return shader;
+}
+
+// unchanged layers are drawn straight from their texture without an upload
+static void render_layers(UiInstance *instance, SimpleShaderEntry *entry,
+                          Vec4f view, uint8_t below) {
+  int32_t last_z = INT32_MIN;
+  int32_t last_id = -1;
+  // walk the layers in (z, id) order without sorting them in place
+  while (1) {
+    Layer *next = NULL;
+    int32_t next_id = -1;
+    for (uint32_t i = 0; i < instance->layer_count; i++) {
+      Layer *layer = &instance->layers[i];
+      if (!layer->in_use || (layer->z < 0) != below)
+        continue;
+      if (layer->z < last_z || (layer->z == last_z && (int32_t)i <= last_id))
+        continue;
+      if (!next || layer->z < next->z) {
+        next = layer;
+        next_id = i;
+      }
+    }
+    if (!next)
+      return;
+    last_z = next->z;
+    last_id = next_id;
+    if (!next->visible || !next->image.buffer || next->alpha <= 0)
+      continue;
+    move_image_buffer_to_texture(&next->image);
+    Shader *shader = use_image_shader(instance, &next->image, next->alpha);
+    shader_set4f(shader, "view", view.x, view.y, view.z, view.w);
+    glBindTexture(GL_TEXTURE_2D, next->image.texture_id);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SimpleShaderEntry), entry);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 6, 1);
+  }
+}
 
+static void draw_window(UiInstance *instance) {
+  instance->needs_render = 0;
   glfwMakeContextCurrent(instance->window);
   glfwGetFramebufferSize(instance->window, &instance->window_width,
                          &instance->window_height);
   glViewport(0, 0, instance->window_width, instance->window_height);
-  shader_set2f(instance->shader, "resolution", (float)instance->window_width,
-               (float)instance->window_height);
   RgbaColor clear_color = instance->clear_color;
   glClearColor((float)clear_color.r / 255, (float)clear_color.g / 255,
                (float)clear_color.b / 255, (float)clear_color.a / 255);
   glClear(GL_COLOR_BUFFER_BIT);
+  if (instance->scene)
+    update_scene(instance);
   move_image_buffer_to_texture(&(instance->render_buffer));
   Vec2f window_size;
   Vec2f start_pos = {0, 0};
-  float bufferAspectRatio = (float)instance->render_buffer.w / (float)instance->render_buffer.h;
+  Vec4f view = image_view(instance);
+  float bufferAspectRatio = view.z / view.w;
   float windowAspectRatio = (float)instance->window_width / (float)instance->window_height;
 
 
@@ -114,13 +316,48 @@ uint8_t render_window(UiInstance *instance) {
     window_size.x = instance->window_height * bufferAspectRatio;
     start_pos.x = (instance->window_width - window_size.x) / 2;
   }
+  instance->image_rect =
+      vec4f(start_pos.x, start_pos.y, window_size.x, window_size.y);
   SimpleShaderEntry entry = {normalize(instance, start_pos), window_size};
-  shader_use(instance->shader);
-  glBindTexture(GL_TEXTURE_2D, instance->render_buffer.texture_id);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SimpleShaderEntry), &entry);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 6, 1);
+  Image *image = content_image(instance);
+  // layers share the view of the content image, normalized to their size
+  Vec4f layer_view = vec4f(view.x / image->w, view.y / image->h,
+                           view.z / image->w, view.w / image->h);
+  render_layers(instance, &entry, layer_view, 1);
+  Shader *image_shader = use_image_shader(instance, image, 1.0f);
+  if (instance->waterfall) {
+    // sample the ring starting at the oldest or newest row
+    float head = (float)instance->waterfall_head / instance->render_buffer.h;
+    shader_set2f(image_shader, "scroll",
+                 instance->waterfall_newest_on_top ? -1.0f : 1.0f, head);
+  }
+  if (instance->tiled) {
+    render_tiled_image(instance, image_shader, start_pos, window_size, view);
+  } else {
+    shader_set4f(image_shader, "view", layer_view.x, layer_view.y,
+                 layer_view.z, layer_view.w);
+    glBindTexture(GL_TEXTURE_2D, instance->render_buffer.texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                    instance->waterfall ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SimpleShaderEntry), &entry);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 6, 1);
+  }
+  render_layers(instance, &entry, layer_view, 0);
+  render_panels(instance);
+  render_scatter_sets(instance, start_pos, window_size);
+  render_line_series(instance, start_pos, window_size);
+  // labels are anchored in buffer pixels but keep their size in pixels
+  float scale_x = window_size.x / view.z, scale_y = window_size.y / view.w;
+  render_texts(instance, vec4f(start_pos.x - view.x * scale_x,
+                               start_pos.y - view.y * scale_y, scale_x,
+                               scale_y));
+}
+
+uint8_t render_window(UiInstance *instance) {
+  draw_window(instance);
   glfwSwapBuffers(instance->window);
+  startup_record(STARTUP_FIRST_FRAME, g_first_window_start);
   if (instance->is_managed)
     glfwPollEvents();
   if (glfwWindowShouldClose(instance->window)) {
@@ -129,20 +366,577 @@ uint8_t render_window(UiInstance *instance) {
   return 0;
 }
 
+uint8_t request_render(UiInstance *instance) {
+  instance->needs_render = 1;
+  return 0;
+}
+
+static uint8_t image_needs_upload(Image *image) {
+  return image->dirty || image->mipmaps_stale;
+}
+
+static uint8_t instance_is_dirty(UiInstance *instance) {
+  if (instance->needs_render || image_needs_upload(&instance->render_buffer))
+    return 1;
+  int32_t w, h;
+  glfwGetFramebufferSize(instance->window, &w, &h);
+  if (w != instance->window_width || h != instance->window_height)
+    return 1;
+  for (uint32_t i = 0; i < instance->layer_count; i++) {
+    if (instance->layers[i].in_use && instance->layers[i].visible &&
+        image_needs_upload(&instance->layers[i].image))
+      return 1;
+  }
+  for (uint32_t i = 0; i < instance->panel_count; i++) {
+    if (instance->panels[i].in_use && instance->panels[i].visible &&
+        image_needs_upload(&instance->panels[i].image))
+      return 1;
+  }
+  return 0;
+}
+
+static void set_swap_interval(UiInstance *instance, int32_t interval) {
+  if (instance->swap_interval == interval)
+    return;
+  glfwSwapInterval(interval);
+  instance->swap_interval = interval;
+}
+
+/*
+ * Draws every managed window that changed since its last frame and polls
+ * events once for all of them. Only the first window presented waits for
+ * vsync, the others swap right away so the waits do not add up with the
+ * number of windows. Returns how many windows were presented.
+ */
+uint32_t render_all() {
+  uint32_t presented = 0;
+  for (ListEntry *p = g_list.head; p != NULL; p = p->next) {
+    UiInstance *instance = p->instance;
+    if (!instance->is_managed || !instance_is_dirty(instance))
+      continue;
+    draw_window(instance);
+    set_swap_interval(instance, presented == 0 ? 1 : 0);
+    glfwSwapBuffers(instance->window);
+    startup_record(STARTUP_FIRST_FRAME, g_first_window_start);
+    presented++;
+  }
+  if (g_init)
+    glfwPollEvents();
+  // close callbacks may dispose their instance, so keep the next entry first
+  ListEntry *p = g_list.head;
+  while (p != NULL) {
+    ListEntry *next = p->next;
+    UiInstance *instance = p->instance;
+    if (instance->is_managed && glfwWindowShouldClose(instance->window))
+      ((close_callback *)instance->close_callback)(instance);
+    p = next;
+  }
+  return presented;
+}
+
 uint8_t dispose_instance(UiInstance *instance) {
   list_remove(&g_list, (ListEntry *)instance->list_entry);
   instance->list_entry = NULL;
-  glfwDestroyWindow(instance->window);
+  // gl objects have to be deleted while the context still exists
+  glfwMakeContextCurrent(instance->window);
   if (instance->render_buffer.texture_was_allocated)
     glDeleteTextures(1, &(instance->render_buffer.texture_id));
   if (instance->render_buffer.buffer)
     free(instance->render_buffer.buffer);
+  if (instance->tiled)
+    dispose_tiled_image(instance->tiled);
+  for (uint32_t i = 0; i < instance->layer_count; i++)
+    remove_layer(instance, i);
+  free(instance->layers);
+  dispose_panels(instance);
+  dispose_texts(instance);
+  dispose_scene(instance);
+  if (instance->colormap_texture)
+    glDeleteTextures(1, &instance->colormap_texture);
+  if (instance->scalar_shader)
+    dispose_shader(instance->scalar_shader);
+  if (instance->scalar_uint_shader)
+    dispose_shader(instance->scalar_uint_shader);
+  if (instance->palette_texture)
+    glDeleteTextures(1, &instance->palette_texture);
+  if (instance->indexed_shader)
+    dispose_shader(instance->indexed_shader);
 
-  glDeleteProgram(instance->shader->pid);
-  free(instance->shader);
+  for (uint32_t i = 0; i < instance->line_count; i++)
+    remove_line_series(instance, i);
+  free(instance->lines);
+  if (instance->line_shader)
+    dispose_shader(instance->line_shader);
+  for (uint32_t i = 0; i < instance->scatter_count; i++)
+    remove_scatter_set(instance, i);
+  free(instance->scatters);
+  if (instance->scatter_shader)
+    dispose_shader(instance->scatter_shader);
+  if (instance->density_shader)
+    dispose_shader(instance->density_shader);
+  if (instance->density_fbo) {
+    glDeleteFramebuffers(1, &instance->density_fbo);
+    glDeleteTextures(1, &instance->density_texture);
+  }
+  dispose_shader(instance->shader);
+  glfwMakeContextCurrent(NULL);
+  glfwDestroyWindow(instance->window);
   free(instance);
   return 0;
 }
+
+uint8_t point_buffer_init(PointBuffer *buffer, uint32_t stride,
+                          uint32_t capacity) {
+  memset(buffer, 0, sizeof(PointBuffer));
+  buffer->data = malloc(sizeof(float) * stride * capacity);
+  if (!buffer->data)
+    return 1;
+  buffer->stride = stride;
+  buffer->capacity = capacity;
+  return 0;
+}
+
+void point_buffer_free(PointBuffer *buffer) {
+  if (buffer->vbo)
+    glDeleteBuffers(1, &buffer->vbo);
+  free(buffer->data);
+  memset(buffer, 0, sizeof(PointBuffer));
+}
+
+void point_buffer_append(PointBuffer *buffer, const float *points,
+                         uint32_t count) {
+  const uint32_t stride = buffer->stride;
+  if (count >= buffer->capacity) {
+    points += (size_t)(count - buffer->capacity) * stride;
+    count = buffer->capacity;
+    buffer->count = 0;
+    buffer->uploaded = 0;
+  }
+  if (buffer->count + count > buffer->capacity) {
+    // drop the oldest points, keeping half the buffer free so this
+    // re-upload only happens every capacity / 2 points
+    uint32_t keep = buffer->capacity / 2;
+    if (keep > buffer->capacity - count)
+      keep = buffer->capacity - count;
+    if (keep > buffer->count)
+      keep = buffer->count;
+    memmove(buffer->data, buffer->data + (size_t)(buffer->count - keep) * stride,
+            sizeof(float) * stride * keep);
+    buffer->count = keep;
+    buffer->uploaded = 0;
+  }
+  memcpy(buffer->data + (size_t)buffer->count * stride, points,
+         sizeof(float) * stride * count);
+  buffer->count += count;
+}
+
+// leaves the vbo bound to GL_ARRAY_BUFFER
+void point_buffer_upload(PointBuffer *buffer) {
+  const size_t point_size = sizeof(float) * buffer->stride;
+  if (!buffer->vbo)
+    glGenBuffers(1, &buffer->vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+  if (buffer->vbo_capacity != buffer->capacity) {
+    glBufferData(GL_ARRAY_BUFFER, point_size * buffer->capacity, NULL,
+                 GL_DYNAMIC_DRAW);
+    buffer->vbo_capacity = buffer->capacity;
+    buffer->uploaded = 0;
+  }
+  if (buffer->uploaded < buffer->count) {
+    glBufferSubData(GL_ARRAY_BUFFER, point_size * buffer->uploaded,
+                    point_size * (buffer->count - buffer->uploaded),
+                    buffer->data + (size_t)buffer->uploaded * buffer->stride);
+    buffer->uploaded = buffer->count;
+  }
+}
+
+static LineSeries *get_line_series(UiInstance *instance, int32_t id) {
+  if (id < 0 || (uint32_t)id >= instance->line_count)
+    return NULL;
+  LineSeries *series = &instance->lines[id];
+  return series->in_use ? series : NULL;
+}
+
+int32_t add_line_series(UiInstance *instance, uint32_t capacity) {
+  if (capacity < 2)
+    return -1;
+  uint32_t id = 0;
+  while (id < instance->line_count && instance->lines[id].in_use)
+    id++;
+  if (id == instance->line_count) {
+    LineSeries *resized = realloc(instance->lines,
+                                  sizeof(LineSeries) * (instance->line_count + 1));
+    if (!resized)
+      return -1;
+    instance->lines = resized;
+    instance->line_count++;
+  }
+  LineSeries *series = &instance->lines[id];
+  memset(series, 0, sizeof(LineSeries));
+  if (point_buffer_init(&series->points, 2, capacity))
+    return -1;
+  series->in_use = 1;
+  series->visible = 1;
+  RgbaColor color = {.r = 0, .g = 50, .b = 200, .a = 255};
+  series->color = color;
+  series->width = 2;
+  instance->needs_render = 1;
+  return id;
+}
+
+uint8_t remove_line_series(UiInstance *instance, int32_t id) {
+  LineSeries *series = get_line_series(instance, id);
+  if (!series)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  point_buffer_free(&series->points);
+  memset(series, 0, sizeof(LineSeries));
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t line_series_append(UiInstance *instance, int32_t id, const float *xy,
+                           uint32_t count) {
+  LineSeries *series = get_line_series(instance, id);
+  if (!series)
+    return 1;
+  point_buffer_append(&series->points, xy, count);
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t line_series_clear(UiInstance *instance, int32_t id) {
+  LineSeries *series = get_line_series(instance, id);
+  if (!series)
+    return 1;
+  series->points.count = 0;
+  series->points.uploaded = 0;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t line_series_style(UiInstance *instance, int32_t id, uint8_t r,
+                          uint8_t g, uint8_t b, uint8_t a, float width) {
+  LineSeries *series = get_line_series(instance, id);
+  if (!series)
+    return 1;
+  RgbaColor color = {.r = r, .g = g, .b = b, .a = a};
+  series->color = color;
+  series->width = width > 0 ? width : 1;
+  series->visible = a > 0;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_line_range(UiInstance *instance, float x_min, float x_max,
+                       float y_min, float y_max) {
+  if (x_min == x_max || y_min == y_max)
+    return 1;
+  instance->line_range = vec4f(x_min, y_min, x_max, y_max);
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_line_area(UiInstance *instance, float x, float y, float w,
+                      float h) {
+  instance->line_area = vec4f(x, y, w, h);
+  instance->needs_render = 1;
+  return 0;
+}
+
+// the area is given in buffer pixels, follow the letterboxed image
+static Vec4f plot_area(UiInstance *instance, Vec2f image_pos,
+                       Vec2f image_size) {
+  Image *image = content_image(instance);
+  Vec4f view = image_view(instance);
+  Vec4f area = instance->line_area;
+  if (area.z <= 0 || area.w <= 0)
+    area = vec4f(0, 0, image->w, image->h);
+  float scale_x = view.z ? image_size.x / view.z : 1;
+  float scale_y = view.w ? image_size.y / view.w : 1;
+  return vec4f(image_pos.x + (area.x - view.x) * scale_x,
+               image_pos.y + (area.y - view.y) * scale_y, area.z * scale_x,
+               area.w * scale_y);
+}
+
+// the visible part of a plot area, zooming can push it past the image
+static Vec4f plot_clip(UiInstance *instance, Vec4f area) {
+  Vec4f rect = instance->image_rect;
+  float x0 = area.x > rect.x ? area.x : rect.x;
+  float y0 = area.y > rect.y ? area.y : rect.y;
+  float x1 = area.x + area.z < rect.x + rect.z ? area.x + area.z
+                                               : rect.x + rect.z;
+  float y1 = area.y + area.w < rect.y + rect.w ? area.y + area.w
+                                               : rect.y + rect.w;
+  return vec4f(x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0);
+}
+
+static void plot_scissor(UiInstance *instance, Vec4f area) {
+  Vec4f clip = plot_clip(instance, area);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor((GLint)clip.x, (GLint)(instance->window_height - clip.y - clip.w),
+            (GLsizei)(clip.z + 0.5f), (GLsizei)(clip.w + 0.5f));
+}
+
+void render_line_series(UiInstance *instance, Vec2f image_pos,
+                        Vec2f image_size) {
+  if (instance->line_count == 0)
+    return;
+  if (!instance->line_shader) {
+    ShaderVar vars[2] = {{2, sizeof(Vec2f), GL_FLOAT, (void *)0},
+                         {2, sizeof(Vec2f), GL_FLOAT, (void *)sizeof(Vec2f)}};
+    instance->line_shader =
+        create_shader(LINE_SHADER_VERT, LINE_SHADER_FRAG, 0, vars, 2);
+  }
+  Vec4f area = plot_area(instance, image_pos, image_size);
+  Shader *shader = instance->line_shader;
+  shader_use(shader);
+  shader_set2f(shader, "resolution", (float)instance->window_width,
+               (float)instance->window_height);
+  shader_set4f(shader, "area", area.x, area.y, area.z, area.w);
+  Vec4f range = instance->line_range;
+  shader_set4f(shader, "range", range.x, range.y, range.z, range.w);
+  plot_scissor(instance, area);
+  // segments are emitted in either winding depending on their direction
+  glDisable(GL_CULL_FACE);
+  for (uint32_t i = 0; i < instance->line_count; i++) {
+    LineSeries *series = &instance->lines[i];
+    if (!series->in_use || !series->visible || series->points.count < 2)
+      continue;
+    point_buffer_upload(&series->points);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2f), (void *)0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2f),
+                          (void *)sizeof(Vec2f));
+    RgbaColor color = series->color;
+    shader_set4f(shader, "line_color", (float)color.r / 255,
+                 (float)color.g / 255, (float)color.b / 255,
+                 (float)color.a / 255);
+    shader_set1f(shader, "width", series->width);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, series->points.count - 1);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glEnable(GL_CULL_FACE);
+  glDisable(GL_SCISSOR_TEST);
+}
+
+static ScatterSet *get_scatter_set(UiInstance *instance, int32_t id) {
+  if (id < 0 || (uint32_t)id >= instance->scatter_count)
+    return NULL;
+  ScatterSet *set = &instance->scatters[id];
+  return set->in_use ? set : NULL;
+}
+
+int32_t add_scatter_set(UiInstance *instance, uint32_t capacity) {
+  if (capacity == 0)
+    return -1;
+  uint32_t id = 0;
+  while (id < instance->scatter_count && instance->scatters[id].in_use)
+    id++;
+  if (id == instance->scatter_count) {
+    ScatterSet *resized =
+        realloc(instance->scatters,
+                sizeof(ScatterSet) * (instance->scatter_count + 1));
+    if (!resized)
+      return -1;
+    instance->scatters = resized;
+    instance->scatter_count++;
+  }
+  ScatterSet *set = &instance->scatters[id];
+  memset(set, 0, sizeof(ScatterSet));
+  // x, y, size, colour index
+  if (point_buffer_init(&set->points, 4, capacity))
+    return -1;
+  set->in_use = 1;
+  set->visible = 1;
+  set->density_scale = 0.2f;
+  static const uint8_t default_palette[] = {0,   50,  200, 255, 200, 50,
+                                            0,   255, 0,   150, 50,  255,
+                                            150, 0,   150, 255};
+  scatter_set_palette(instance, id, default_palette, 4);
+  instance->needs_render = 1;
+  return id;
+}
+
+uint8_t remove_scatter_set(UiInstance *instance, int32_t id) {
+  ScatterSet *set = get_scatter_set(instance, id);
+  if (!set)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  point_buffer_free(&set->points);
+  memset(set, 0, sizeof(ScatterSet));
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t scatter_append(UiInstance *instance, int32_t id, const float *points,
+                       uint32_t count) {
+  ScatterSet *set = get_scatter_set(instance, id);
+  if (!set)
+    return 1;
+  point_buffer_append(&set->points, points, count);
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t scatter_clear(UiInstance *instance, int32_t id) {
+  ScatterSet *set = get_scatter_set(instance, id);
+  if (!set)
+    return 1;
+  set->points.count = 0;
+  set->points.uploaded = 0;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t scatter_set_palette(UiInstance *instance, int32_t id,
+                            const uint8_t *rgba, uint32_t count) {
+  ScatterSet *set = get_scatter_set(instance, id);
+  if (!set || count == 0)
+    return 1;
+  // unset entries repeat the given colours
+  for (uint32_t i = 0; i < 16 * 4; i++)
+    set->palette[i] = (float)rgba[i % (count * 4)] / 255;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t scatter_set_density(UiInstance *instance, int32_t id, uint8_t enabled,
+                            float scale) {
+  ScatterSet *set = get_scatter_set(instance, id);
+  if (!set)
+    return 1;
+  set->density = enabled;
+  if (scale > 0)
+    set->density_scale = scale;
+  instance->needs_render = 1;
+  return 0;
+}
+
+static uint8_t ensure_density_target(UiInstance *instance, int32_t w,
+                                     int32_t h) {
+  if (instance->density_fbo && instance->density_w == w &&
+      instance->density_h == h)
+    return 0;
+  if (!instance->density_fbo) {
+    glGenFramebuffers(1, &instance->density_fbo);
+    glGenTextures(1, &instance->density_texture);
+  }
+  glBindTexture(GL_TEXTURE_2D, instance->density_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, w, h, 0, GL_RED, GL_FLOAT, NULL);
+  glBindFramebuffer(GL_FRAMEBUFFER, instance->density_fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         instance->density_texture, 0);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+    return 1;
+  instance->density_w = w;
+  instance->density_h = h;
+  return 0;
+}
+
+static void draw_scatter_points(Shader *shader, ScatterSet *set) {
+  point_buffer_upload(&set->points);
+  const GLsizei stride = sizeof(float) * 4;
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void *)0);
+  glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(sizeof(float) * 2));
+  glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(sizeof(float) * 3));
+  glUniform4fv(glGetUniformLocation(shader->pid, "palette"), 16, set->palette);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, set->points.count);
+}
+
+/*
+ * Density sets are accumulated additively into a float texture the size of
+ * the plot area and then resolved onto the window through an exponential
+ * ramp between the first two palette entries.
+ */
+static void render_scatter_density(UiInstance *instance, ScatterSet *set,
+                                   Vec4f area) {
+  // only the visible part is accumulated, the target stays window sized
+  Vec4f clip = plot_clip(instance, area);
+  int32_t w = (int32_t)(clip.z + 0.5f), h = (int32_t)(clip.w + 0.5f);
+  if (w <= 0 || h <= 0 || ensure_density_target(instance, w, h))
+    return;
+  Shader *shader = instance->scatter_shader;
+  glDisable(GL_SCISSOR_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, instance->density_fbo);
+  glViewport(0, 0, w, h);
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glBlendFunc(GL_ONE, GL_ONE);
+  shader_use(shader);
+  shader_set2f(shader, "resolution", (float)w, (float)h);
+  shader_set4f(shader, "area", area.x - clip.x, area.y - clip.y, area.z,
+               area.w);
+  shader_set1i(shader, "density", 1);
+  draw_scatter_points(shader, set);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, instance->window_width, instance->window_height);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  if (!instance->density_shader)
+    instance->density_shader =
+        create_shader(DENSITY_SHADER_VERT, DENSITY_SHADER_FRAG, 0, NULL, 0);
+  Shader *resolve = instance->density_shader;
+  shader_use(resolve);
+  shader_set2f(resolve, "resolution", (float)instance->window_width,
+               (float)instance->window_height);
+  shader_set4f(resolve, "area", clip.x, clip.y, (float)w, (float)h);
+  shader_set1f(resolve, "scale", set->density_scale);
+  shader_set4f(resolve, "low", set->palette[0], set->palette[1],
+               set->palette[2], set->palette[3]);
+  shader_set4f(resolve, "high", set->palette[4], set->palette[5],
+               set->palette[6], set->palette[7]);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, instance->density_texture);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  plot_scissor(instance, area);
+}
+
+void render_scatter_sets(UiInstance *instance, Vec2f image_pos,
+                         Vec2f image_size) {
+  if (instance->scatter_count == 0)
+    return;
+  if (!instance->scatter_shader) {
+    ShaderVar vars[3] = {{2, sizeof(float) * 4, GL_FLOAT, (void *)0},
+                         {1, sizeof(float) * 4, GL_FLOAT,
+                          (void *)(sizeof(float) * 2)},
+                         {1, sizeof(float) * 4, GL_FLOAT,
+                          (void *)(sizeof(float) * 3)}};
+    instance->scatter_shader =
+        create_shader(SCATTER_SHADER_VERT, SCATTER_SHADER_FRAG, 0, vars, 3);
+  }
+  Vec4f area = plot_area(instance, image_pos, image_size);
+  Shader *shader = instance->scatter_shader;
+  Vec4f range = instance->line_range;
+  plot_scissor(instance, area);
+  glDisable(GL_CULL_FACE);
+  for (uint32_t i = 0; i < instance->scatter_count; i++) {
+    ScatterSet *set = &instance->scatters[i];
+    if (!set->in_use || !set->visible || set->points.count == 0)
+      continue;
+    shader_use(shader);
+    shader_set4f(shader, "range", range.x, range.y, range.z, range.w);
+    if (set->density) {
+      render_scatter_density(instance, set, area);
+      continue;
+    }
+    shader_set2f(shader, "resolution", (float)instance->window_width,
+                 (float)instance->window_height);
+    shader_set4f(shader, "area", area.x, area.y, area.z, area.w);
+    shader_set1i(shader, "density", 0);
+    draw_scatter_points(shader, set);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glEnable(GL_CULL_FACE);
+  glDisable(GL_SCISSOR_TEST);
+}
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
                   int mods) {
   ListEntry *entry = list_find_window(&g_list, window);
@@ -224,8 +1018,46 @@ uint8_t move_buffer_to_image(UiInstance *target, uint8_t *buffer, uint32_t w,
   const uint8_t pixel_size = get_buffer_pixel_size(&target->render_buffer);
   image_buffer_resize(&(target->render_buffer), w, h);
   memcpy((&target->render_buffer)->buffer, buffer, w * h * pixel_size);
+  target->render_buffer.dirty = 1;
+  target->needs_render = 1;
   return 0;
 }
+/*
+ * Takes the w * h pixels at x, y of a larger source with rows stride pixels
+ * apart, a crop or one tile of a mosaic. The rows are copied into the buffer,
+ * when the texture already has the right storage they are also uploaded right
+ * away straight from source.
+ */
+uint8_t move_buffer_region_to_image(UiInstance *target, const uint8_t *source,
+                                    uint32_t stride, uint32_t x, uint32_t y,
+                                    uint32_t w, uint32_t h) {
+  Image *image = &target->render_buffer;
+  if (w == 0 || h == 0 || (uint64_t)x + w > stride)
+    return 1;
+  const size_t pixel_size = get_buffer_pixel_size(image);
+  image_buffer_resize(image, w, h);
+  if (!image->buffer)
+    return 1;
+  for (uint32_t row = 0; row < h; row++)
+    memcpy(image->buffer + (size_t)row * w * pixel_size,
+           source + ((size_t)(y + row) * stride + x) * pixel_size,
+           (size_t)w * pixel_size);
+  target->needs_render = 1;
+  if (image->dirty || !image->texture_was_allocated ||
+      image->texture_w != w || image->texture_h != h ||
+      image->texture_type != image->type) {
+    image->dirty = 1;
+    return 0;
+  }
+  glfwMakeContextCurrent(target->window);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, image->texture_id);
+  upload_region(image, 0, 0, w, h, source, stride, x, y);
+  if (image->mipmaps)
+    image->mipmaps_stale = 1;
+  return 0;
+}
+
 void image_buffer_resize(Image *image, uint32_t w, uint32_t h) {
   const uint8_t pixel_size = get_buffer_pixel_size(image);
   if (image->buffer) {
@@ -240,40 +1072,127 @@ void image_buffer_resize(Image *image, uint32_t w, uint32_t h) {
   image->buffer_size = w * h * pixel_size;
   image->w = w;
   image->h = h;
+  image->dirty = 1;
 }
 uint8_t get_buffer_pixel_size(Image *in) {
   if (in->type == RGB)
     return 3;
+  if (in->type == R16 || in->type == R16UI)
+    return 2;
+  if (in->type == INDEXED8)
+    return 1;
+  if (in->type == RGBA16F)
+    return 8;
   return 4;
 }
+
+uint8_t image_is_scalar(Image *in) {
+  return in->type == R32F || in->type == R16 || in->type == R16UI;
+}
+
+uint8_t image_is_color(Image *in) {
+  return in->type == RGBA || in->type == RGB || in->type == BGRA;
+}
+
+uint8_t image_is_integer(Image *in) {
+  return in->type == INDEXED8 || in->type == R16UI;
+}
+
+GLint image_filter(Image *in) {
+  return image_is_integer(in) ? GL_NEAREST : GL_LINEAR;
+}
 void allocate_texture(Image *image) {
   if (image->texture_was_allocated) {
     glDeleteTextures(1, &(image->texture_id));
   }
   glGenTextures(1, &(image->texture_id));
   image->texture_was_allocated = 1;
+  image->texture_w = 0;
+  image->texture_h = 0;
+  image->dirty = 1;
 }
 
 void move_image_buffer_to_texture(Image *buffer) {
-  if (!buffer->texture_was_allocated)
+  // integer textures have no mipmaps and are never filtered
+  const uint8_t mipmaps = buffer->mipmaps && !image_is_integer(buffer);
+  const GLint filter = image_filter(buffer);
+  if (buffer->texture_was_allocated && buffer->mipmaps_stale && mipmaps &&
+      !buffer->dirty) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, buffer->texture_id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    buffer->mipmaps_stale = 0;
+  }
+  if (!buffer->texture_was_allocated || !buffer->dirty)
     return;
+  if (buffer->type == RGB || buffer->type == BGRA)
+    upload_calibrate();
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, buffer->texture_id);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   GLint color_t = get_type_enum(buffer, 0);
-  GLint p_type = get_type_enum(buffer, 1);
-  glTexImage2D(GL_TEXTURE_2D, 0, p_type, (GLsizei)buffer->w, (GLsizei)buffer->h,
-               0, color_t, GL_UNSIGNED_BYTE, NULL);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, buffer->w, buffer->h, color_t,
-                  GL_UNSIGNED_BYTE, buffer->buffer);
+  GLint data_t = get_type_enum(buffer, 2);
+  // storage is only reallocated when the size or format changes
+  if (buffer->texture_w != buffer->w || buffer->texture_h != buffer->h ||
+      buffer->texture_type != buffer->type) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    mipmaps ? GL_LINEAR_MIPMAP_LINEAR : filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmaps ? 1000 : 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, upload_internal_format(buffer),
+                 (GLsizei)buffer->w, (GLsizei)buffer->h, 0, color_t, data_t,
+                 NULL);
+    upload_texture_setup(buffer);
+    buffer->texture_w = buffer->w;
+    buffer->texture_h = buffer->h;
+    buffer->texture_type = buffer->type;
+  }
+  upload_pixels(buffer, 0, 0, buffer->w, buffer->h, buffer->buffer,
+                buffer->w);
+  if (mipmaps)
+    glGenerateMipmap(GL_TEXTURE_2D);
+  buffer->mipmaps_stale = 0;
+  buffer->dirty = 0;
+}
+
+void image_upload_rect(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                       uint32_t h) {
+  if (image->dirty || !image->texture_was_allocated ||
+      image->texture_w != image->w || image->texture_h != image->h ||
+      image->texture_type != image->type) {
+    image->dirty = 1;
+    return;
+  }
+  if (w == 0 || h == 0)
+    return;
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, image->texture_id);
+  upload_region(image, x, y, w, h, image->buffer, image->w, x, y);
+  if (image->mipmaps)
+    image->mipmaps_stale = 1;
 }
 
+// type 0 is the pixel format, 1 the internal format and 2 the component type
 GLint get_type_enum(Image *in, uint8_t type) {
+  if (in->type == RGBA16F) {
+    if (type == 2)
+      return GL_HALF_FLOAT;
+    return type == 1 ? GL_RGBA16F : GL_RGBA;
+  }
+  if (in->type == RGB10_A2) {
+    if (type == 2)
+      return GL_UNSIGNED_INT_2_10_10_10_REV;
+    return type == 1 ? GL_RGB10_A2 : GL_RGBA;
+  }
+  if (in->type == R16UI) {
+    if (type == 2)
+      return GL_UNSIGNED_SHORT;
+    return type == 1 ? GL_R16UI : GL_RED_INTEGER;
+  }
+  if (type == 2 && !image_is_scalar(in))
+    return GL_UNSIGNED_BYTE;
   if (in->type == RGB) {
     return type == 1 ? GL_RGB8 : GL_RGB;
   }
@@ -283,18 +1202,284 @@ GLint get_type_enum(Image *in, uint8_t type) {
   if (in->type == BGRA) {
     return type == 1 ? GL_RGBA8 : GL_BGRA;
   }
+  if (in->type == R32F) {
+    if (type == 2)
+      return GL_FLOAT;
+    return type == 1 ? GL_R32F : GL_RED;
+  }
+  if (in->type == R16) {
+    if (type == 2)
+      return GL_UNSIGNED_SHORT;
+    return type == 1 ? GL_R16 : GL_RED;
+  }
+  if (in->type == INDEXED8) {
+    return type == 1 ? GL_R8UI : GL_RED_INTEGER;
+  }
   return 0;
 }
 
 uint8_t set_buffer_color_type(UiInstance *instance, const char *type) {
-  Image *render_buffer = &instance->render_buffer;
-  if (string_match(type, "rgb")) {
-    render_buffer->type = RGB;
-  } else if (string_match(type, "rgba")) {
-    render_buffer->type = RGBA;
-  } else if (string_match(type, "bgra")) {
-    render_buffer->type = BGRA;
+  instance->needs_render = 1;
+  return image_set_type(&instance->render_buffer, type);
+}
+
+// -1 for names that are not an ImageType
+static int32_t parse_image_type(const char *type) {
+  // in ImageType order
+  static const char *names[] = {"rgba",    "rgb",   "bgra",
+                                "r32f",    "r16",   "indexed8",
+                                "rgba16f", "r16ui", "rgb10_a2"};
+  for (int32_t i = 0; i < (int32_t)(sizeof(names) / sizeof(names[0])); i++) {
+    if (string_match(type, names[i]))
+      return i;
   }
+  return -1;
+}
+
+uint8_t image_set_type(Image *image, const char *type) {
+  int32_t parsed = parse_image_type(type);
+  if (parsed < 0)
+    return 1;
+  const uint8_t pixel_size = get_buffer_pixel_size(image);
+  image->type = (enum ImageType)parsed;
+  // the old pixels mean nothing in the new size, start from a cleared buffer
+  // so an upload before the next update never reads past the allocation
+  if (image->buffer && get_buffer_pixel_size(image) != pixel_size) {
+    free(image->buffer);
+    image->buffer = NULL;
+    image_buffer_resize(image, image->w, image->h);
+  }
+  image->dirty = 1;
+  return 0;
+}
+
+uint8_t get_image_type_info(const char *type, int32_t *out) {
+  int32_t parsed = parse_image_type(type);
+  if (parsed < 0)
+    return 1;
+  Image image = {0};
+  image.type = (enum ImageType)parsed;
+  out[0] = get_buffer_pixel_size(&image);
+  out[1] = get_type_enum(&image, 1);
+  out[2] = get_type_enum(&image, 0);
+  out[3] = get_type_enum(&image, 2);
+  return 0;
+}
+
+Layer *get_layer(UiInstance *instance, int32_t id) {
+  if (id < 0 || (uint32_t)id >= instance->layer_count)
+    return NULL;
+  Layer *layer = &instance->layers[id];
+  return layer->in_use ? layer : NULL;
+}
+
+int32_t add_layer(UiInstance *instance, int32_t z) {
+  uint32_t id = 0;
+  while (id < instance->layer_count && instance->layers[id].in_use)
+    id++;
+  if (id == instance->layer_count) {
+    Layer *resized =
+        realloc(instance->layers, sizeof(Layer) * (instance->layer_count + 1));
+    if (!resized)
+      return -1;
+    instance->layers = resized;
+    instance->layer_count++;
+  }
+  Layer *layer = &instance->layers[id];
+  memset(layer, 0, sizeof(Layer));
+  layer->in_use = 1;
+  layer->visible = 1;
+  layer->z = z;
+  layer->alpha = 1;
+  layer->image.type = RGBA;
+  glfwMakeContextCurrent(instance->window);
+  allocate_texture(&layer->image);
+  instance->needs_render = 1;
+  return id;
+}
+
+uint8_t remove_layer(UiInstance *instance, int32_t id) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  glDeleteTextures(1, &layer->image.texture_id);
+  free(layer->image.buffer);
+  memset(layer, 0, sizeof(Layer));
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t update_layer(UiInstance *instance, int32_t id, const uint8_t *buffer,
+                     uint32_t w, uint32_t h) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  image_buffer_resize(&layer->image, w, h);
+  memcpy(layer->image.buffer, buffer, layer->image.buffer_size);
+  layer->image.dirty = 1;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_layer_color_type(UiInstance *instance, int32_t id,
+                             const char *type) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  instance->needs_render = 1;
+  return image_set_type(&layer->image, type);
+}
+
+uint8_t set_layer_visible(UiInstance *instance, int32_t id, uint8_t visible) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  layer->visible = visible;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_layer_z(UiInstance *instance, int32_t id, int32_t z) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  layer->z = z;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_layer_alpha(UiInstance *instance, int32_t id, float alpha) {
+  Layer *layer = get_layer(instance, id);
+  if (!layer)
+    return 1;
+  layer->alpha = alpha < 0 ? 0 : alpha > 1 ? 1 : alpha;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_colormap(UiInstance *instance, const uint8_t *rgba,
+                     uint32_t count) {
+  if (count == 0)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  upload_colormap(&instance->colormap_texture, rgba, count);
+  instance->needs_render = 1;
+  return 0;
+}
+
+// contrast of the content image, only uniforms change so nothing is uploaded
+uint8_t set_window_level(UiInstance *instance, float window, float level) {
+  if (window <= 0)
+    return 1;
+  instance->contrast_window = window;
+  instance->contrast_level = level;
+  instance->needs_render = 1;
+  return 0;
+}
+
+// only the changed entries are uploaded, the image itself is not touched
+uint8_t set_palette(UiInstance *instance, const uint8_t *rgba, uint32_t first,
+                    uint32_t count) {
+  if (count == 0 || first >= 256 || count > 256 - first)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  upload_palette(&instance->palette_texture, rgba, first, count);
+  instance->needs_render = 1;
+  return 0;
+}
+
+// zooming and panning only changes the view uniform, nothing is uploaded
+uint8_t set_view(UiInstance *instance, float x, float y, float w, float h) {
+  if (w < 0 || h < 0)
+    return 1;
+  instance->view = vec4f(x, y, w, h);
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_mipmaps(UiInstance *instance, uint8_t enabled) {
+  Image *image = &instance->render_buffer;
+  if (image->mipmaps == enabled)
+    return 0;
+  image->mipmaps = enabled;
+  // the filters are set up when the storage is allocated
+  image->texture_w = 0;
+  image->dirty = 1;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_waterfall(UiInstance *instance, uint32_t w, uint32_t rows,
+                      uint8_t newest_on_top) {
+  Image *image = &instance->render_buffer;
+  if (w == 0 || rows == 0) {
+    instance->waterfall = 0;
+    instance->needs_render = 1;
+    return 0;
+  }
+  image_buffer_resize(image, w, rows);
+  memset(image->buffer, 0, image->buffer_size);
+  image->dirty = 1;
+  instance->waterfall = 1;
+  instance->waterfall_newest_on_top = newest_on_top;
+  instance->waterfall_head = 0;
+  instance->needs_render = 1;
+  return 0;
+}
+
+/*
+ * Rows are written into the ring and uploaded one contiguous span at a time,
+ * so a new row costs a single row upload instead of the whole image.
+ */
+uint8_t waterfall_push_rows(UiInstance *instance, const uint8_t *rows,
+                            uint32_t count) {
+  Image *image = &instance->render_buffer;
+  if (!instance->waterfall || !image->buffer)
+    return 1;
+  const size_t row_size = (size_t)image->w * get_buffer_pixel_size(image);
+  if (count > image->h) {
+    rows += (count - image->h) * row_size;
+    count = image->h;
+  }
+  // until the texture storage matches the next frame uploads everything
+  uint8_t upload = !image->dirty && image->texture_w == image->w &&
+                   image->texture_h == image->h &&
+                   image->texture_type == image->type;
+  if (upload) {
+    glfwMakeContextCurrent(instance->window);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, image->texture_id);
+  }
+  while (count > 0) {
+    uint32_t head = instance->waterfall_head;
+    uint32_t chunk = image->h - head;
+    if (chunk > count)
+      chunk = count;
+    memcpy(image->buffer + head * row_size, rows, chunk * row_size);
+    if (upload)
+      upload_pixels(image, 0, head, image->w, chunk,
+                    image->buffer + head * row_size, image->w);
+    rows += chunk * row_size;
+    count -= chunk;
+    instance->waterfall_head = (head + chunk) % image->h;
+  }
+  // mipmaps are rebuilt once per frame instead of per push
+  if (upload && image->mipmaps)
+    image->mipmaps_stale = 1;
+  if (!upload)
+    image->dirty = 1;
+  instance->needs_render = 1;
+  return 0;
+}
+
+// only changes uniforms, the scalar data is not uploaded again
+uint8_t set_scalar_range(UiInstance *instance, float min, float max) {
+  if (min == max)
+    return 1;
+  instance->scalar_min = min;
+  instance->scalar_max = max;
+  instance->needs_render = 1;
   return 0;
 }
 
@@ -351,10 +1536,13 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos) {
   ListEntry *entry = list_find_window(&g_list, window);
   if (entry == NULL)
     return;
-  if (entry->instance->mouse_position_callback == NULL)
+  UiInstance *instance = entry->instance;
+  instance->cursor_x = xpos;
+  instance->cursor_y = ypos;
+  route_panel_mouse(instance, -1, 0);
+  if (instance->mouse_position_callback == NULL)
     return;
 
-  UiInstance *instance = entry->instance;
   ((mouse_position_cb_t *)instance->mouse_position_callback)(instance, xpos,
                                                              ypos);
 }
@@ -363,13 +1551,20 @@ void mouse_button_callback(GLFWwindow *window, int button, int action,
   ListEntry *entry = list_find_window(&g_list, window);
   if (entry == NULL)
     return;
-  if (entry->instance->mouse_button_callback == NULL)
+  UiInstance *instance = entry->instance;
+  route_panel_mouse(instance, button, action);
+  if (instance->mouse_button_callback == NULL)
     return;
 
-  UiInstance *instance = entry->instance;
   ((mouse_button_callback_t *)instance->mouse_button_callback)(instance, button,
                                                                action, mods);
 }
+void window_refresh_callback(GLFWwindow *window) {
+  ListEntry *entry = list_find_window(&g_list, window);
+  if (entry == NULL)
+    return;
+  entry->instance->needs_render = 1;
+}
 void window_focus_callback(GLFWwindow *window, int focused) {
   ListEntry *entry = list_find_window(&g_list, window);
   if (entry == NULL)
@@ -381,6 +1576,13 @@ void window_focus_callback(GLFWwindow *window, int focused) {
   ((window_focus_callback_t *)instance->window_focus_callback)(instance,
                                                                focused);
 }
+// the program belongs to the share group, only the vao and vbo are per window
+void dispose_shader(Shader *shader) {
+  glDeleteVertexArrays(1, &shader->vao);
+  glDeleteBuffers(1, &shader->vbo);
+  free(shader);
+}
+
 void shader_set2f(Shader *shader, const char *name, float x, float y) {
   glUniform2f(glGetUniformLocation(shader->pid, name), x, y);
 }
@@ -392,6 +1594,10 @@ void shader_set4f(Shader *shader, const char *name, float x, float y, float z,
 void shader_set1f(Shader *shader, const char *name, float v) {
   glUniform1f(glGetUniformLocation(shader->pid, name), v);
 }
+
+void shader_set1i(Shader *shader, const char *name, int32_t v) {
+  glUniform1i(glGetUniformLocation(shader->pid, name), v);
+}
 Shader *create_shader(const char *vertex_content, const char *fragment_content,
                       uint32_t size, ShaderVar *vars, size_t shader_var_len) {
 
@@ -413,17 +1619,12 @@ Shader *create_shader(const char *vertex_content, const char *fragment_content,
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
-  GLuint pid = glCreateProgram();
-  GLuint vertex_shader =
-      simple_compile_shader(GL_VERTEX_SHADER, vertex_content);
-  GLuint fragment_shader =
-      simple_compile_shader(GL_FRAGMENT_SHADER, fragment_content);
-  glAttachShader(pid, vertex_shader);
-  glAttachShader(pid, fragment_shader);
-  glLinkProgram(pid);
-  shader->pid = pid;
-  shader->vertex_shader_id = vertex_shader;
-  shader->fragment_shader_id = fragment_shader;
+  SharedProgram *program = shared_program(vertex_content, fragment_content);
+  if (program) {
+    shader->pid = program->pid;
+    shader->vertex_shader_id = program->vertex_shader_id;
+    shader->fragment_shader_id = program->fragment_shader_id;
+  }
 
   return shader;
 }
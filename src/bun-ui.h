@@ -3,6 +3,7 @@
 
 #include "glad.h"
 #include "la.h"
+#include "automap.h"
 #include <GLFW/glfw3.h>
 #ifdef __cplusplus
 extern "C" {
@@ -11,6 +12,8 @@ extern "C" {
 #define IMAGE_SHADER_VERT                                                      \
   "#version 330 core\n"                                                        \
   "uniform vec2 resolution;\n"                                                 \
+  "uniform vec2 scroll;\n"                                                     \
+  "uniform vec4 view;\n"                                                       \
   "layout(location = 0) in vec2 position;\n"                                   \
   "layout(location = 1) in vec2 size;\n"                                       \
   "vec2 camera_project(vec2 point) {\n"                                        \
@@ -20,27 +23,248 @@ extern "C" {
   "void main() {\n"                                                            \
   "vec2 uvIn = vec2(float(gl_VertexID & 1),\n"                                 \
   "              float((gl_VertexID >> 1) & 1));\n"                            \
-  "    uv = uvIn;\n"                                                           \
+  "    vec2 source = view.xy + uvIn * view.zw;\n"                              \
+  "    uv = vec2(source.x, scroll.y + scroll.x * source.y);\n"                 \
   "    vec2 r = camera_project(uvIn * size + position);\n"                     \
   "    r.y *= -1;\n"                                                           \
   "   gl_Position = vec4(r, 0.0f, 1.0f);\n"                                    \
   "}"
 
+// window is the width of the input range mapped to 0..1, level its center,
+// scalar types apply it to their position within the scalar range
 #define IMAGE_SHADER_FRAG                                                      \
   "#version 330 core\n"                                                        \
   "uniform sampler2D img;\n"                                                   \
+  "uniform float alpha;\n"                                                     \
+  "uniform float window;\n"                                                    \
+  "uniform float level;\n"                                                     \
   "in vec2 uv;\n"                                                              \
   "out vec4 color;\n"                                                          \
   "void main() {\n"                                                            \
   "  color = texture(img, uv);\n"                                              \
+  "  color.rgb = clamp((color.rgb - (level - 0.5 * window)) / window,\n"       \
+  "                    0.0, 1.0);\n"                                           \
+  "  color.a *= alpha;\n"                                                      \
   "} \n"
 
+#define SCALAR_SHADER_FRAG                                                     \
+  "#version 330 core\n"                                                        \
+  "uniform sampler2D img;\n"                                                   \
+  "uniform sampler1D colormap;\n"                                              \
+  "uniform float value_scale;\n"                                               \
+  "uniform vec2 value_range;\n"                                                \
+  "uniform float alpha;\n"                                                     \
+  "uniform float window;\n"                                                    \
+  "uniform float level;\n"                                                     \
+  "in vec2 uv;\n"                                                              \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  float v = texture(img, uv).r * value_scale;\n"                            \
+  "  if (isnan(v))\n"                                                          \
+  "    discard;\n"                                                             \
+  "  float t = (v - value_range.x) / (value_range.y - value_range.x);\n"      \
+  "  t = clamp((t - (level - 0.5 * window)) / window, 0.0, 1.0);\n"            \
+  "  float n = float(textureSize(colormap, 0));\n"                             \
+  "  color = texture(colormap, (t * (n - 1.0) + 0.5) / n);\n"                  \
+  "  color.a *= alpha;\n"                                                      \
+  "}"
+
+#define SCALAR_UINT_SHADER_FRAG                                                \
+  "#version 330 core\n"                                                        \
+  "uniform usampler2D img;\n"                                                  \
+  "uniform sampler1D colormap;\n"                                              \
+  "uniform vec2 value_range;\n"                                                \
+  "uniform float alpha;\n"                                                     \
+  "uniform float window;\n"                                                    \
+  "uniform float level;\n"                                                     \
+  "in vec2 uv;\n"                                                              \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  float v = float(texture(img, uv).r);\n"                                   \
+  "  float t = (v - value_range.x) / (value_range.y - value_range.x);\n"      \
+  "  t = clamp((t - (level - 0.5 * window)) / window, 0.0, 1.0);\n"            \
+  "  float n = float(textureSize(colormap, 0));\n"                             \
+  "  color = texture(colormap, (t * (n - 1.0) + 0.5) / n);\n"                  \
+  "  color.a *= alpha;\n"                                                      \
+  "}"
+
+// integer texture, nearest sampled so indices are never blended
+#define INDEXED_SHADER_FRAG                                                    \
+  "#version 330 core\n"                                                        \
+  "uniform usampler2D img;\n"                                                  \
+  "uniform sampler1D palette;\n"                                               \
+  "uniform float alpha;\n"                                                     \
+  "in vec2 uv;\n"                                                              \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  color = texelFetch(palette, int(texture(img, uv).r), 0);\n"               \
+  "  color.a *= alpha;\n"                                                      \
+  "}"
+
+#define LINE_SHADER_VERT                                                       \
+  "#version 330 core\n"                                                        \
+  "uniform vec2 resolution;\n"                                                 \
+  "uniform vec4 area;\n"                                                       \
+  "uniform vec4 range;\n"                                                      \
+  "uniform float width;\n"                                                     \
+  "layout(location = 0) in vec2 p0;\n"                                         \
+  "layout(location = 1) in vec2 p1;\n"                                         \
+  "out float edge;\n"                                                          \
+  "vec2 to_screen(vec2 p) {\n"                                                 \
+  "  vec2 t = (p - range.xy) / (range.zw - range.xy);\n"                       \
+  "  return vec2(area.x + t.x * area.z, area.y + (1.0 - t.y) * area.w);\n"     \
+  "}\n"                                                                        \
+  "void main() {\n"                                                            \
+  "  vec2 a = to_screen(p0);\n"                                                \
+  "  vec2 b = to_screen(p1);\n"                                                \
+  "  vec2 dir = b - a;\n"                                                      \
+  "  float len = length(dir);\n"                                               \
+  "  dir = len > 0.0 ? dir / len : vec2(1.0, 0.0);\n"                          \
+  "  vec2 normal = vec2(-dir.y, dir.x);\n"                                     \
+  "  float half_width = width * 0.5 + 1.0;\n"                                  \
+  "  float side = float(gl_VertexID & 1) * 2.0 - 1.0;\n"                       \
+  "  float end = float((gl_VertexID >> 1) & 1);\n"                             \
+  "  vec2 pos = mix(a, b, end) + dir * (end * 2.0 - 1.0) * width * 0.5 +\n"    \
+  "             normal * side * half_width;\n"                                 \
+  "  edge = side * half_width;\n"                                              \
+  "  vec2 r = 2.0 * pos / resolution - 1.0;\n"                                 \
+  "  r.y *= -1;\n"                                                             \
+  "  gl_Position = vec4(r, 0.0f, 1.0f);\n"                                     \
+  "}"
+
+#define LINE_SHADER_FRAG                                                       \
+  "#version 330 core\n"                                                        \
+  "uniform vec4 line_color;\n"                                                 \
+  "uniform float width;\n"                                                     \
+  "in float edge;\n"                                                           \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  float coverage = clamp(width * 0.5 + 0.5 - abs(edge), 0.0, 1.0);\n"       \
+  "  color = vec4(line_color.rgb, line_color.a * coverage);\n"                 \
+  "}"
+
+#define SCATTER_SHADER_VERT                                                    \
+  "#version 330 core\n"                                                        \
+  "uniform vec2 resolution;\n"                                                 \
+  "uniform vec4 area;\n"                                                       \
+  "uniform vec4 range;\n"                                                      \
+  "uniform vec4 palette[16];\n"                                                \
+  "layout(location = 0) in vec2 position;\n"                                   \
+  "layout(location = 1) in float size;\n"                                      \
+  "layout(location = 2) in float color_index;\n"                               \
+  "out vec2 local;\n"                                                          \
+  "out float radius;\n"                                                        \
+  "out vec4 point_color;\n"                                                    \
+  "void main() {\n"                                                            \
+  "  vec2 t = (position - range.xy) / (range.zw - range.xy);\n"                \
+  "  vec2 center = vec2(area.x + t.x * area.z, area.y + (1.0 - t.y) * area.w);\n"\
+  "  radius = size * 0.5;\n"                                                   \
+  "  vec2 corner = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1));\n"\
+  "  local = (corner * 2.0 - 1.0) * (radius + 1.0);\n"                         \
+  "  point_color = palette[int(color_index) & 15];\n"                          \
+  "  vec2 r = 2.0 * (center + local) / resolution - 1.0;\n"                    \
+  "  r.y *= -1;\n"                                                             \
+  "  gl_Position = vec4(r, 0.0f, 1.0f);\n"                                     \
+  "}"
+
+#define SCATTER_SHADER_FRAG                                                    \
+  "#version 330 core\n"                                                        \
+  "uniform int density;\n"                                                     \
+  "in vec2 local;\n"                                                           \
+  "in float radius;\n"                                                         \
+  "in vec4 point_color;\n"                                                     \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  float coverage = clamp(radius + 0.5 - length(local), 0.0, 1.0);\n"        \
+  "  if (coverage <= 0.0)\n"                                                   \
+  "    discard;\n"                                                             \
+  "  if (density == 1)\n"                                                      \
+  "    color = vec4(coverage, 0.0, 0.0, 1.0);\n"                               \
+  "  else\n"                                                                   \
+  "    color = vec4(point_color.rgb, point_color.a * coverage);\n"             \
+  "}"
+
+#define DENSITY_SHADER_VERT                                                    \
+  "#version 330 core\n"                                                        \
+  "uniform vec2 resolution;\n"                                                 \
+  "uniform vec4 area;\n"                                                       \
+  "out vec2 uv;\n"                                                             \
+  "void main() {\n"                                                            \
+  "  uv = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1));\n"      \
+  "  vec2 r = 2.0 * (area.xy + uv * area.zw) / resolution - 1.0;\n"            \
+  "  r.y *= -1;\n"                                                             \
+  "  uv.y = 1.0 - uv.y;\n"                                                     \
+  "  gl_Position = vec4(r, 0.0f, 1.0f);\n"                                     \
+  "}"
+
+#define DENSITY_SHADER_FRAG                                                    \
+  "#version 330 core\n"                                                        \
+  "uniform sampler2D density_map;\n"                                           \
+  "uniform float scale;\n"                                                     \
+  "uniform vec4 low;\n"                                                        \
+  "uniform vec4 high;\n"                                                       \
+  "in vec2 uv;\n"                                                              \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  float d = texture(density_map, uv).r;\n"                                  \
+  "  if (d <= 0.0)\n"                                                          \
+  "    discard;\n"                                                             \
+  "  float t = 1.0 - exp(-d * scale);\n"                                       \
+  "  color = mix(low, high, t);\n"                                             \
+  "}"
+
+#define TEXT_SHADER_VERT                                                       \
+  "#version 330 core\n"                                                        \
+  "uniform vec2 resolution;\n"                                                 \
+  "uniform vec4 transform;\n"                                                  \
+  "layout(location = 0) in vec2 anchor;\n"                                     \
+  "layout(location = 1) in vec2 offset;\n"                                     \
+  "layout(location = 2) in vec2 size;\n"                                       \
+  "layout(location = 3) in vec4 uv_rect;\n"                                    \
+  "out vec2 uv;\n"                                                             \
+  "void main() {\n"                                                            \
+  "  vec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1);\n"           \
+  "  // whole pixels keep the nearest sampled glyphs crisp\n"                  \
+  "  vec2 origin = floor(transform.xy + anchor * transform.zw + 0.5);\n"       \
+  "  vec2 pos = origin + offset + corner * size;\n"                            \
+  "  uv = uv_rect.xy + corner * uv_rect.zw;\n"                                 \
+  "  vec2 r = 2.0 * pos / resolution - 1.0;\n"                                 \
+  "  r.y *= -1;\n"                                                             \
+  "  gl_Position = vec4(r, 0.0f, 1.0f);\n"                                     \
+  "}"
+
+#define TEXT_SHADER_FRAG                                                       \
+  "#version 330 core\n"                                                        \
+  "uniform sampler2D atlas;\n"                                                 \
+  "uniform vec4 text_color;\n"                                                 \
+  "in vec2 uv;\n"                                                              \
+  "out vec4 color;\n"                                                          \
+  "void main() {\n"                                                            \
+  "  color = vec4(text_color.rgb, text_color.a * texture(atlas, uv).r);\n"     \
+  "}"
+
+
+
 typedef struct {
   size_t len;
   uint8_t *buffer;
 } String;
 
-enum ImageType { RGBA, RGB, BGRA };
+// R32F, R16 and R16UI are single channel scalar fields shaded through a
+// colormap, INDEXED8 holds palette indices looked up on the GPU. RGBA16F
+// (half floats) and RGB10_A2 (packed into 32 bits, red in the low bits) keep
+// more than 8 bits per channel for window/level adjustments.
+enum ImageType {
+  RGBA,
+  RGB,
+  BGRA,
+  R32F,
+  R16,
+  INDEXED8,
+  RGBA16F,
+  R16UI,
+  RGB10_A2
+};
 typedef struct {
   uint32_t w, h;
   uint8_t *buffer;
@@ -48,6 +272,12 @@ typedef struct {
   GLuint texture_id;
   size_t buffer_size;
   uint8_t texture_was_allocated;
+  // set whenever buffer changes, the texture is only updated when dirty
+  uint8_t dirty;
+  uint32_t texture_w, texture_h;
+  enum ImageType texture_type;
+  uint8_t mipmaps;
+  uint8_t mipmaps_stale;
 } Image;
 
 typedef struct {
@@ -75,6 +305,49 @@ typedef struct {
 
 } Shader;
 
+/*
+ * CPU mirror of an append only vertex buffer, stride is in floats per point.
+ * Only the points appended since the last upload are sent to the GPU.
+ */
+typedef struct {
+  uint32_t stride;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t uploaded;
+  float *data;
+  GLuint vbo;
+  uint32_t vbo_capacity;
+} PointBuffer;
+
+typedef struct {
+  uint8_t in_use;
+  uint8_t visible;
+  PointBuffer points;
+  RgbaColor color;
+  float width;
+} LineSeries;
+
+typedef struct {
+  uint8_t in_use;
+  uint8_t visible;
+  uint8_t density;
+  float density_scale;
+  PointBuffer points;
+  float palette[16 * 4];
+} ScatterSet;
+
+/*
+ * Extra image drawn over the same area as render_buffer. Layers with a
+ * negative z are drawn below it, everything else above, in z order.
+ */
+typedef struct {
+  uint8_t in_use;
+  uint8_t visible;
+  int32_t z;
+  float alpha;
+  Image image;
+} Layer;
+
 typedef struct {
   GLFWwindow *window;
   int32_t window_width, window_height;
@@ -82,7 +355,56 @@ typedef struct {
   RgbaColor clear_color;
   uint8_t should_center;
   uint8_t is_managed;
+  // set by every change that shows up on screen, cleared when drawn
+  uint8_t needs_render;
+  // last value given to glfwSwapInterval for this context, -1 before that
+  int32_t swap_interval;
   Shader *shader;
+  Shader *scalar_shader;
+  Shader *scalar_uint_shader;
+  GLuint colormap_texture;
+  Shader *indexed_shader;
+  // 256 rgba entries for INDEXED8 images, 0 uses the shared gray ramp
+  GLuint palette_texture;
+  float scalar_min, scalar_max;
+  // contrast of the content image, see IMAGE_SHADER_FRAG
+  float contrast_window, contrast_level;
+  // render_buffer rows are used as a ring, waterfall_head is the next row
+  uint8_t waterfall;
+  uint8_t waterfall_newest_on_top;
+  uint32_t waterfall_head;
+  // source rect of render_buffer in pixels, zero size shows all of it
+  Vec4f view;
+  // where the image was drawn in the last frame, in window pixels
+  Vec4f image_rect;
+  // replaces render_buffer when set, see tiled.h
+  struct TiledImage *tiled;
+  // retained nodes drawn into render_buffer, see scene.h
+  struct Scene *scene;
+  Layer *layers;
+  uint32_t layer_count;
+  // dashboard panels, see panel.h
+  struct Panel *panels;
+  uint32_t panel_count;
+  uint32_t panel_cols, panel_rows;
+  float panel_gap;
+  double cursor_x, cursor_y;
+  void *panel_mouse_callback;
+  // text items drawn from the shared glyph atlas, see text.h
+  struct TextItem *texts;
+  uint32_t text_count;
+  Shader *text_shader;
+  Shader *line_shader;
+  LineSeries *lines;
+  uint32_t line_count;
+  Vec4f line_range;
+  Vec4f line_area;
+  Shader *scatter_shader;
+  Shader *density_shader;
+  ScatterSet *scatters;
+  uint32_t scatter_count;
+  GLuint density_fbo, density_texture;
+  int32_t density_w, density_h;
   void *close_callback;
   void *key_callback;
   void *text_callback;
@@ -122,6 +444,7 @@ void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow *window, int button, int action,
                            int mods);
 void window_focus_callback(GLFWwindow *window, int focused);
+void window_refresh_callback(GLFWwindow *window);
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
                   int mods);
@@ -138,7 +461,17 @@ ListEntry *list_find_window(List *list, GLFWwindow *window);
 
 uint8_t get_buffer_pixel_size(Image *in);
 
+uint8_t image_is_scalar(Image *in);
+// 8 bit rgb, rgba or bgra, the types the CPU rasterizer draws into
+uint8_t image_is_color(Image *in);
+// integer textures, never filtered and without mipmaps
+uint8_t image_is_integer(Image *in);
+// GL_NEAREST for types that must not be blended, GL_LINEAR otherwise
+GLint image_filter(Image *in);
+
 GLint get_type_enum(Image *in, uint8_t type);
+// pixel size, GL internal format, format and component type of a type name
+uint8_t get_image_type_info(const char *type, int32_t *out);
 
 uint8_t string_match(const char *lhs, const char *rhs);
 
@@ -146,6 +479,37 @@ uint8_t set_clear_color(UiInstance *instance, uint8_t r, uint8_t g, uint8_t b);
 
 uint8_t set_buffer_color_type(UiInstance *instance, const char *type);
 
+uint8_t image_set_type(Image *image, const char *type);
+
+int32_t add_layer(UiInstance *instance, int32_t z);
+uint8_t remove_layer(UiInstance *instance, int32_t id);
+// NULL for ids that are not in use
+Layer *get_layer(UiInstance *instance, int32_t id);
+uint8_t update_layer(UiInstance *instance, int32_t id, const uint8_t *buffer,
+                     uint32_t w, uint32_t h);
+uint8_t set_layer_color_type(UiInstance *instance, int32_t id,
+                             const char *type);
+uint8_t set_layer_visible(UiInstance *instance, int32_t id, uint8_t visible);
+uint8_t set_layer_z(UiInstance *instance, int32_t id, int32_t z);
+uint8_t set_layer_alpha(UiInstance *instance, int32_t id, float alpha);
+
+uint8_t set_colormap(UiInstance *instance, const uint8_t *rgba, uint32_t count);
+
+uint8_t set_scalar_range(UiInstance *instance, float min, float max);
+uint8_t set_window_level(UiInstance *instance, float window, float level);
+uint8_t set_palette(UiInstance *instance, const uint8_t *rgba, uint32_t first,
+                    uint32_t count);
+
+uint8_t set_view(UiInstance *instance, float x, float y, float w, float h);
+
+uint8_t set_mipmaps(UiInstance *instance, uint8_t enabled);
+
+uint8_t set_waterfall(UiInstance *instance, uint32_t w, uint32_t rows,
+                      uint8_t newest_on_top);
+
+uint8_t waterfall_push_rows(UiInstance *instance, const uint8_t *rows,
+                            uint32_t count);
+
 uint8_t set_keyboard_callback(UiInstance *instance, void *callback);
 uint8_t set_text_callback(UiInstance *instance, void *callback);
 uint8_t set_framebuffer_callback(UiInstance *instance, void *callback);
@@ -160,6 +524,9 @@ const char *get_clipboard(UiInstance *instance);
 
 uint8_t move_buffer_to_image(UiInstance *target, uint8_t *buffer, uint32_t w,
                              uint32_t h);
+uint8_t move_buffer_region_to_image(UiInstance *target, const uint8_t *source,
+                                    uint32_t stride, uint32_t x, uint32_t y,
+                                    uint32_t w, uint32_t h);
 
 uint8_t dispose_instance(UiInstance *instance);
 
@@ -174,6 +541,9 @@ void shader_set2f(Shader *shader, const char *name, float x, float y);
 void shader_set4f(Shader *shader, const char *name, float x, float y, float z,
                   float w);
 void shader_set1f(Shader *shader, const char *name, float v);
+void shader_set1i(Shader *shader, const char *name, int32_t v);
+
+Shader *use_image_shader(UiInstance *instance, Image *image, float alpha);
 
 int bun_ui_init();
 
@@ -183,6 +553,11 @@ void image_buffer_resize(Image *image, uint32_t w, uint32_t h);
 
 void move_image_buffer_to_texture(Image *buffer);
 
+// uploads only this part of the buffer, falls back to a full upload when the
+// texture storage is not current
+void image_upload_rect(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                       uint32_t h);
+
 Vec2f normalize(UiInstance *instance, Vec2f in);
 
 UiInstance *create_window(char *window_title, size_t buffer_w, size_t buffer_h,
@@ -190,6 +565,45 @@ UiInstance *create_window(char *window_title, size_t buffer_w, size_t buffer_h,
                           void *close_callback);
 
 uint8_t render_window(UiInstance *instance);
+
+uint8_t request_render(UiInstance *instance);
+
+uint32_t render_all();
+
+int32_t add_line_series(UiInstance *instance, uint32_t capacity);
+uint8_t remove_line_series(UiInstance *instance, int32_t id);
+uint8_t line_series_append(UiInstance *instance, int32_t id, const float *xy,
+                           uint32_t count);
+uint8_t line_series_clear(UiInstance *instance, int32_t id);
+uint8_t line_series_style(UiInstance *instance, int32_t id, uint8_t r,
+                          uint8_t g, uint8_t b, uint8_t a, float width);
+uint8_t set_line_range(UiInstance *instance, float x_min, float x_max,
+                       float y_min, float y_max);
+uint8_t set_line_area(UiInstance *instance, float x, float y, float w,
+                      float h);
+void render_line_series(UiInstance *instance, Vec2f image_pos,
+                        Vec2f image_size);
+
+int32_t add_scatter_set(UiInstance *instance, uint32_t capacity);
+uint8_t remove_scatter_set(UiInstance *instance, int32_t id);
+uint8_t scatter_append(UiInstance *instance, int32_t id, const float *points,
+                       uint32_t count);
+uint8_t scatter_clear(UiInstance *instance, int32_t id);
+uint8_t scatter_set_palette(UiInstance *instance, int32_t id,
+                            const uint8_t *rgba, uint32_t count);
+uint8_t scatter_set_density(UiInstance *instance, int32_t id, uint8_t enabled,
+                            float scale);
+void render_scatter_sets(UiInstance *instance, Vec2f image_pos,
+                         Vec2f image_size);
+
+uint8_t point_buffer_init(PointBuffer *buffer, uint32_t stride,
+                          uint32_t capacity);
+void point_buffer_free(PointBuffer *buffer);
+void point_buffer_append(PointBuffer *buffer, const float *points,
+                         uint32_t count);
+void point_buffer_upload(PointBuffer *buffer);
+
+void dispose_shader(Shader *shader);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,353 @@
+#include "convert.h"
+#include "pool.h"
+#include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CONVERT_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CONVERT_NEON
+#endif
+
+// rows converted by one pool task
+#define CONVERT_BAND 64
+
+// channel offsets of red, green, blue and alpha, -1 when missing
+typedef struct {
+  uint8_t size;
+  int8_t r, g, b, a;
+  uint8_t premultiplied;
+} PixelLayout;
+
+static uint8_t parse_layout(const char *type, PixelLayout *layout) {
+  static const PixelLayout rgb = {3, 0, 1, 2, -1, 0};
+  static const PixelLayout rgba = {4, 0, 1, 2, 3, 0};
+  static const PixelLayout bgra = {4, 2, 1, 0, 3, 0};
+  static const PixelLayout rgba_premul = {4, 0, 1, 2, 3, 1};
+  static const PixelLayout bgra_premul = {4, 2, 1, 0, 3, 1};
+  if (string_match(type, "rgb"))
+    *layout = rgb;
+  else if (string_match(type, "rgba"))
+    *layout = rgba;
+  else if (string_match(type, "bgra"))
+    *layout = bgra;
+  else if (string_match(type, "rgba_premul"))
+    *layout = rgba_premul;
+  else if (string_match(type, "bgra_premul"))
+    *layout = bgra_premul;
+  else
+    return 1;
+  return 0;
+}
+
+enum ConvertOp {
+  CONVERT_COPY,
+  // reorders bytes, also covers rgb to premultiplied since alpha is 255
+  CONVERT_SHUFFLE,
+  CONVERT_PREMULTIPLY,
+  // anything that divides by alpha, scalar only
+  CONVERT_GENERIC
+};
+
+typedef struct ConvertJob ConvertJob;
+// converts the first pixels it can, returns how many, the rest is scalar
+typedef size_t convert_rows_t(const ConvertJob *job, const uint8_t *in,
+                              uint8_t *out, size_t pixels);
+
+struct ConvertJob {
+  const uint8_t *src;
+  uint8_t *dst;
+  PixelLayout from, to;
+  uint32_t w, h;
+  enum ConvertOp op;
+  convert_rows_t *rows;
+  // pshufb masks for four pixels: the source byte of every output byte
+  // (0x80 for none), bytes or'ed in after the shuffle (missing alpha), the
+  // output byte holding the alpha every byte is multiplied with and 255 in
+  // the alpha bytes themselves
+  uint8_t shuffle[16], fill[16], alpha[16], alpha_lanes[16];
+};
+
+static uint8_t mul_div255(uint32_t c, uint32_t a) {
+  uint32_t t = c * a + 128;
+  return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+static uint8_t div_alpha(uint32_t c, uint32_t a) {
+  if (a == 0)
+    return 0;
+  uint32_t v = (c * 255 + a / 2) / a;
+  return v > 255 ? 255 : (uint8_t)v;
+}
+
+static void convert_scalar(const ConvertJob *job, const uint8_t *in,
+                           uint8_t *out, size_t pixels) {
+  const PixelLayout from = job->from, to = job->to;
+  for (size_t i = 0; i < pixels; i++) {
+    uint8_t r = in[from.r], g = in[from.g], b = in[from.b];
+    uint8_t a = from.a < 0 ? 255 : in[from.a];
+    if (a != 255 && from.premultiplied != to.premultiplied) {
+      if (from.premultiplied) {
+        r = div_alpha(r, a);
+        g = div_alpha(g, a);
+        b = div_alpha(b, a);
+      } else {
+        r = mul_div255(r, a);
+        g = mul_div255(g, a);
+        b = mul_div255(b, a);
+      }
+    }
+    out[to.r] = r;
+    out[to.g] = g;
+    out[to.b] = b;
+    if (to.a >= 0)
+      out[to.a] = a;
+    in += from.size;
+    out += to.size;
+  }
+}
+
+#ifdef CONVERT_X86
+__attribute__((target("ssse3"))) static __m128i
+premultiply_ssse3(__m128i v, __m128i alpha, __m128i alpha_lanes) {
+  const __m128i zero = _mm_setzero_si128(), half = _mm_set1_epi16(128);
+  __m128i a = _mm_or_si128(_mm_shuffle_epi8(v, alpha), alpha_lanes);
+  __m128i lo = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), _mm_unpacklo_epi8(a, zero)),
+      half);
+  __m128i hi = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), _mm_unpackhi_epi8(a, zero)),
+      half);
+  lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+  hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+  return _mm_packus_epi16(lo, hi);
+}
+
+// four pixels per step, 16 byte loads and stores never leave the band
+__attribute__((target("ssse3"))) static size_t
+rows_ssse3(const ConvertJob *job, const uint8_t *in, uint8_t *out,
+           size_t pixels) {
+  const __m128i shuffle = _mm_loadu_si128((const __m128i *)job->shuffle);
+  const __m128i fill = _mm_loadu_si128((const __m128i *)job->fill);
+  const __m128i alpha = _mm_loadu_si128((const __m128i *)job->alpha);
+  const __m128i lanes = _mm_loadu_si128((const __m128i *)job->alpha_lanes);
+  const size_t in_size = job->from.size, out_size = job->to.size;
+  const size_t reach = in_size == out_size ? 4 : 6;
+  size_t i = 0;
+  if (job->op != CONVERT_SHUFFLE && job->op != CONVERT_PREMULTIPLY)
+    return 0;
+  for (; i + reach <= pixels; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(in + i * in_size));
+    v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), fill);
+    if (job->op == CONVERT_PREMULTIPLY)
+      v = premultiply_ssse3(v, alpha, lanes);
+    _mm_storeu_si128((__m128i *)(out + i * out_size), v);
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static __m256i
+premultiply_avx2(__m256i v, __m256i alpha, __m256i alpha_lanes) {
+  const __m256i zero = _mm256_setzero_si256(), half = _mm256_set1_epi16(128);
+  __m256i a = _mm256_or_si256(_mm256_shuffle_epi8(v, alpha), alpha_lanes);
+  __m256i lo = _mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero),
+                         _mm256_unpacklo_epi8(a, zero)),
+      half);
+  __m256i hi = _mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero),
+                         _mm256_unpackhi_epi8(a, zero)),
+      half);
+  lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+  hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+  return _mm256_packus_epi16(lo, hi);
+}
+
+// eight pixels per step, shuffles stay within 128 bit lanes so 3 byte pixels
+// are moved to 12 bytes per lane before and after
+__attribute__((target("avx2"))) static size_t
+rows_avx2(const ConvertJob *job, const uint8_t *in, uint8_t *out,
+          size_t pixels) {
+  const __m256i shuffle = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)job->shuffle));
+  const __m256i fill = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)job->fill));
+  const __m256i alpha = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)job->alpha));
+  const __m256i lanes = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)job->alpha_lanes));
+  const __m256i spread = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+  const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+  const size_t in_size = job->from.size, out_size = job->to.size;
+  const size_t reach = in_size == out_size ? 8 : 11;
+  size_t i = 0;
+  if (job->op != CONVERT_SHUFFLE && job->op != CONVERT_PREMULTIPLY)
+    return 0;
+  for (; i + reach <= pixels; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(in + i * in_size));
+    if (in_size == 3)
+      v = _mm256_permutevar8x32_epi32(v, spread);
+    v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), fill);
+    if (job->op == CONVERT_PREMULTIPLY)
+      v = premultiply_avx2(v, alpha, lanes);
+    if (out_size == 3)
+      v = _mm256_permutevar8x32_epi32(v, gather);
+    _mm256_storeu_si256((__m256i *)(out + i * out_size), v);
+  }
+  return i;
+}
+#endif
+
+#ifdef CONVERT_NEON
+static uint8x16_t premultiply_neon(uint8x16_t c, uint8x16_t a) {
+  uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+  uint16x8_t hi = vmull_high_u8(c, a);
+  return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+                     vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+// sixteen pixels per step, the structured loads split channels for free
+static size_t rows_neon(const ConvertJob *job, const uint8_t *in,
+                        uint8_t *out, size_t pixels) {
+  const PixelLayout from = job->from, to = job->to;
+  size_t i = 0;
+  if (job->op != CONVERT_SHUFFLE && job->op != CONVERT_PREMULTIPLY)
+    return 0;
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16_t r, g, b, a;
+    if (from.size == 4) {
+      uint8x16x4_t v = vld4q_u8(in + i * 4);
+      r = v.val[from.r];
+      g = v.val[from.g];
+      b = v.val[from.b];
+      a = v.val[from.a];
+    } else {
+      uint8x16x3_t v = vld3q_u8(in + i * 3);
+      r = v.val[from.r];
+      g = v.val[from.g];
+      b = v.val[from.b];
+      a = vdupq_n_u8(255);
+    }
+    if (job->op == CONVERT_PREMULTIPLY) {
+      r = premultiply_neon(r, a);
+      g = premultiply_neon(g, a);
+      b = premultiply_neon(b, a);
+    }
+    if (to.size == 4) {
+      uint8x16x4_t v;
+      v.val[to.r] = r;
+      v.val[to.g] = g;
+      v.val[to.b] = b;
+      v.val[to.a] = a;
+      vst4q_u8(out + i * 4, v);
+    } else {
+      uint8x16x3_t v;
+      v.val[to.r] = r;
+      v.val[to.g] = g;
+      v.val[to.b] = b;
+      vst3q_u8(out + i * 3, v);
+    }
+  }
+  return i;
+}
+#endif
+
+static uint8_t g_simd_disabled = 0;
+
+uint8_t set_convert_simd(uint8_t enabled) {
+  g_simd_disabled = !enabled;
+  return 0;
+}
+
+uint8_t get_convert_kernel() {
+  if (g_simd_disabled)
+    return CONVERT_KERNEL_SCALAR;
+#if defined(CONVERT_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return CONVERT_KERNEL_AVX2;
+  if (__builtin_cpu_supports("ssse3"))
+    return CONVERT_KERNEL_SSSE3;
+#elif defined(CONVERT_NEON)
+  return CONVERT_KERNEL_NEON;
+#endif
+  return CONVERT_KERNEL_SCALAR;
+}
+
+static convert_rows_t *pick_rows() {
+  switch (get_convert_kernel()) {
+#if defined(CONVERT_X86)
+  case CONVERT_KERNEL_AVX2:
+    return rows_avx2;
+  case CONVERT_KERNEL_SSSE3:
+    return rows_ssse3;
+#elif defined(CONVERT_NEON)
+  case CONVERT_KERNEL_NEON:
+    return rows_neon;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+static void build_masks(ConvertJob *job) {
+  const PixelLayout from = job->from, to = job->to;
+  memset(job->fill, 0, sizeof(job->fill));
+  memset(job->alpha_lanes, 0, sizeof(job->alpha_lanes));
+  memset(job->shuffle, 0x80, sizeof(job->shuffle));
+  memset(job->alpha, 0x80, sizeof(job->alpha));
+  for (uint8_t p = 0; p < 4; p++) {
+    const uint8_t in = p * from.size, out = p * to.size;
+    job->shuffle[out + to.r] = in + from.r;
+    job->shuffle[out + to.g] = in + from.g;
+    job->shuffle[out + to.b] = in + from.b;
+    if (to.a < 0)
+      continue;
+    if (from.a >= 0)
+      job->shuffle[out + to.a] = in + from.a;
+    else
+      job->fill[out + to.a] = 255;
+    job->alpha[out + to.r] = job->alpha[out + to.g] =
+        job->alpha[out + to.b] = out + to.a;
+    job->alpha_lanes[out + to.a] = 255;
+  }
+}
+
+static void convert_band(void *context, uint32_t band) {
+  const ConvertJob *job = context;
+  const uint32_t y0 = band * CONVERT_BAND;
+  const uint32_t y1 = y0 + CONVERT_BAND < job->h ? y0 + CONVERT_BAND : job->h;
+  const size_t pixels = (size_t)(y1 - y0) * job->w;
+  const uint8_t *in = job->src + (size_t)y0 * job->w * job->from.size;
+  uint8_t *out = job->dst + (size_t)y0 * job->w * job->to.size;
+  if (job->op == CONVERT_COPY) {
+    memmove(out, in, pixels * job->from.size);
+    return;
+  }
+  size_t done = job->rows ? job->rows(job, in, out, pixels) : 0;
+  convert_scalar(job, in + done * job->from.size, out + done * job->to.size,
+                 pixels - done);
+}
+
+uint8_t convert_pixels(const uint8_t *src, const char *from, uint8_t *dst,
+                       const char *to, uint32_t w, uint32_t h) {
+  ConvertJob job = {.src = src, .dst = dst, .w = w, .h = h};
+  if (parse_layout(from, &job.from) || parse_layout(to, &job.to))
+    return 1;
+  // in place works band by band only while pixels keep their size
+  if (src == dst && job.from.size != job.to.size)
+    return 1;
+  const PixelLayout f = job.from, t = job.to;
+  if (memcmp(&f, &t, sizeof(PixelLayout)) == 0)
+    job.op = CONVERT_COPY;
+  else if (f.premultiplied == t.premultiplied || f.a < 0)
+    job.op = CONVERT_SHUFFLE;
+  else if (t.premultiplied)
+    job.op = CONVERT_PREMULTIPLY;
+  else
+    job.op = CONVERT_GENERIC;
+  build_masks(&job);
+  job.rows = pick_rows();
+  pool_run(convert_band, &job, (h + CONVERT_BAND - 1) / CONVERT_BAND);
+  return 0;
+}
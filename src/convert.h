@@ -0,0 +1,35 @@
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum ConvertKernel {
+  CONVERT_KERNEL_SCALAR,
+  CONVERT_KERNEL_SSSE3,
+  CONVERT_KERNEL_AVX2,
+  CONVERT_KERNEL_NEON
+};
+
+/*
+ * Converts w * h pixels between "rgb", "rgba", "bgra" and the premultiplied
+ * "rgba_premul" and "bgra_premul" (cairo's raw output), rows are split across
+ * the thread pool. Alpha is 255 when the source has none. src and dst may only
+ * be the same buffer when both types have the same pixel size. Everything but
+ * unpremultiplying runs through the best SIMD kernel the cpu supports.
+ */
+uint8_t convert_pixels(const uint8_t *src, const char *from, uint8_t *dst,
+                       const char *to, uint32_t w, uint32_t h);
+
+// SIMD can be turned off to compare against the scalar path
+uint8_t set_convert_simd(uint8_t enabled);
+// the ConvertKernel convert_pixels uses right now
+uint8_t get_convert_kernel();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,10 +1,48 @@
+#include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <napi.h>
 #include <iostream>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <stdint.h>
 #include <vector>
 #include "bun-ui.h"
+#include "series.h"
+#include "tiled.h"
+#include "panel.h"
+#include "program.h"
+#include "startup.h"
+#include "text.h"
+#include "raster.h"
+#include "scene.h"
+#include "pool.h"
+#include "convert.h"
+#include "upload.h"
+
+// Window events reach JS through one thread safe function, so the callbacks
+// below may run on whichever thread renders or polls. At most one drain is
+// queued at a time, events pile up in pending until it runs on the JS thread.
+enum class EventKind {
+  Close,
+  Key,
+  Text,
+  Focus,
+  FrameBuffer,
+  MousePosition,
+  MouseButton,
+  PanelMouse
+};
+
+struct WindowEvent {
+  EventKind kind;
+  UiInstance *instance;
+  uint8_t count;
+  double args[5];
+};
+
+#define MAX_PENDING_EVENTS 1024
 
 struct NodeState {
   std::map<size_t, UiInstance *> instances;
@@ -20,7 +58,15 @@ struct NodeState {
       mouseButtonCallbacks;
   std::unordered_map<UiInstance *, Napi::FunctionReference>
       frameBufferCallbacks;
+  std::unordered_map<UiInstance *, Napi::FunctionReference>
+      panelMouseCallbacks;
   size_t idx = 0;
+  std::map<size_t, SeriesStore *> series;
+  size_t series_idx = 0;
+  Napi::ThreadSafeFunction events;
+  std::mutex eventLock;
+  std::deque<WindowEvent> pendingEvents;
+  bool drainQueued = false;
 };
 NodeState *node_state_g = nullptr;
 
@@ -32,66 +78,148 @@ size_t getIndexFromInstance(UiInstance *instance) {
   return 0;
 }
 
-uint8_t naa_close_cb(UiInstance *instance) {
+std::unordered_map<UiInstance *, Napi::FunctionReference> *
+eventCallbacks(EventKind kind) {
+  switch (kind) {
+  case EventKind::Close:
+    return &node_state_g->windowCloseCallbacks;
+  case EventKind::Key:
+    return &node_state_g->keyboardCallbacks;
+  case EventKind::Text:
+    return &node_state_g->textCallbacks;
+  case EventKind::Focus:
+    return &node_state_g->windowFocusCallbacks;
+  case EventKind::FrameBuffer:
+    return &node_state_g->frameBufferCallbacks;
+  case EventKind::MousePosition:
+    return &node_state_g->mousePositionCallbacks;
+  case EventKind::MouseButton:
+    return &node_state_g->mouseButtonCallbacks;
+  case EventKind::PanelMouse:
+    return &node_state_g->panelMouseCallbacks;
+  }
+  return nullptr;
+}
+
+// only the latest value of these matters to the listener, panel movement
+// reports button -1 and is merged per panel
+static bool eventReplaces(const WindowEvent &last, const WindowEvent &event) {
+  if (last.kind != event.kind || last.instance != event.instance)
+    return false;
+  switch (event.kind) {
+  case EventKind::Close:
+  case EventKind::Focus:
+  case EventKind::FrameBuffer:
+  case EventKind::MousePosition:
+    return true;
+  case EventKind::PanelMouse:
+    return last.args[0] == event.args[0] && last.args[3] == -1 &&
+           event.args[3] == -1;
+  default:
+    return false;
+  }
+}
+
+void IgnoreEvent(const Napi::CallbackInfo &) {}
+
+void deliverEvents(Napi::Env env, Napi::Function) {
+  std::deque<WindowEvent> batch;
+  {
+    std::lock_guard<std::mutex> guard(node_state_g->eventLock);
+    batch.swap(node_state_g->pendingEvents);
+    node_state_g->drainQueued = false;
+  }
+  std::vector<napi_value> args;
+  for (auto &event : batch) {
+    // the window may have been disposed while the event waited
+    auto *map = eventCallbacks(event.kind);
+    auto entry = map->find(event.instance);
+    if (entry == map->end())
+      continue;
+    args.clear();
+    args.push_back(
+        Napi::Number::New(env, getIndexFromInstance(event.instance)));
+    for (uint8_t i = 0; i < event.count; i++)
+      args.push_back(Napi::Number::New(env, event.args[i]));
+    entry->second.Call(args);
+  }
+}
+
+void queueEvent(EventKind kind, UiInstance *instance,
+                std::initializer_list<double> values) {
+  WindowEvent event = {kind, instance, (uint8_t)values.size(), {}};
+  std::copy(values.begin(), values.end(), event.args);
+  std::lock_guard<std::mutex> guard(node_state_g->eventLock);
+  auto &pending = node_state_g->pendingEvents;
+  // replacing only the newest pending event keeps the order relative to
+  // other events, a move between two clicks is never merged across them
+  if (!pending.empty() && eventReplaces(pending.back(), event)) {
+    pending.back() = event;
+    return;
+  }
+  // the JS thread is stalled, dropping beats growing without bound
+  if (pending.size() >= MAX_PENDING_EVENTS)
+    return;
+  pending.push_back(event);
+  if (node_state_g->drainQueued)
+    return;
+  node_state_g->drainQueued =
+      node_state_g->events.NonBlockingCall(deliverEvents) == napi_ok;
+}
 
-  auto &func = node_state_g->windowCloseCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance))});
+// drops undelivered events of a disposed window, its address may be reused
+void forgetEvents(UiInstance *instance) {
+  std::lock_guard<std::mutex> guard(node_state_g->eventLock);
+  auto &pending = node_state_g->pendingEvents;
+  pending.erase(std::remove_if(pending.begin(), pending.end(),
+                               [instance](const WindowEvent &event) {
+                                 return event.instance == instance;
+                               }),
+                pending.end());
+}
+
+uint8_t naa_close_cb(UiInstance *instance) {
+  queueEvent(EventKind::Close, instance, {});
   return 0;
 }
 
 uint8_t naa_key_cb(UiInstance *instance, int32_t key, int32_t scancode,
                    int32_t action, int32_t mods) {
-  auto &func = node_state_g->keyboardCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, key), Napi::Number::New(env, scancode),
-             Napi::Number::New(env, action), Napi::Number::New(env, mods)});
+  queueEvent(EventKind::Key, instance,
+             {(double)key, (double)scancode, (double)action, (double)mods});
   return 0;
 }
 uint8_t naa_text_cb(UiInstance *instance, uint32_t cp) {
-
-  auto &func = node_state_g->textCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, cp)});
+  queueEvent(EventKind::Text, instance, {(double)cp});
   return 0;
 }
 
 uint8_t naa_window_focus_cb(UiInstance *instance, uint32_t cp) {
-
-  auto &func = node_state_g->windowFocusCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, cp)});
+  queueEvent(EventKind::Focus, instance, {(double)cp});
   return 0;
 }
 
 uint8_t naa_fb_cb(UiInstance *instance, int32_t w, int32_t h, float xscale,
                   float yscale) {
-  auto &func = node_state_g->frameBufferCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, w), Napi::Number::New(env, h),
-             Napi::Number::New(env, xscale), Napi::Number::New(env, yscale)});
+  queueEvent(EventKind::FrameBuffer, instance,
+             {(double)w, (double)h, (double)xscale, (double)yscale});
   return 0;
 }
 uint8_t naa_mouse_pos_cb(UiInstance *instance, double x, double y) {
-
-  auto &func = node_state_g->mousePositionCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, x), Napi::Number::New(env, y)});
+  queueEvent(EventKind::MousePosition, instance, {x, y});
   return 0;
 }
 
 uint8_t naa_mouse_button_cb(UiInstance *instance, int32_t button,
                             int32_t action, int32_t mods) {
-  auto &func = node_state_g->mouseButtonCallbacks[instance];
-  auto env = func.Env();
-  func.Call({Napi::Number::New(env, getIndexFromInstance(instance)),
-             Napi::Number::New(env, button), Napi::Number::New(env, action),
-             Napi::Number::New(env, mods)});
+  queueEvent(EventKind::MouseButton, instance,
+             {(double)button, (double)action, (double)mods});
+  return 0;
+}
+uint8_t naa_panel_mouse_cb(UiInstance *instance, int32_t panel, double x,
+                           double y, int32_t button, int32_t action) {
+  queueEvent(EventKind::PanelMouse, instance,
+             {(double)panel, x, y, (double)button, (double)action});
   return 0;
 }
 void push_callback(
@@ -145,6 +273,61 @@ Napi::Value RenderWindow(const Napi::CallbackInfo &info) {
 
   return Napi::Number::New(env, 0);
 }
+uint8_t *typedArrayData(const Napi::Value &value) {
+  if (!value.IsTypedArray())
+    return nullptr;
+  Napi::TypedArray array = value.As<Napi::TypedArray>();
+  return (uint8_t *)array.ArrayBuffer().Data() + array.ByteOffset();
+}
+
+/*
+ * Runs work on the libuv thread pool and settles a promise with its result.
+ * The arrays it reads or writes are referenced until then, so the garbage
+ * collector cannot free them while the worker still uses their memory.
+ */
+class TaskWorker : public Napi::AsyncWorker {
+public:
+  TaskWorker(Napi::Env env, std::function<uint8_t()> work,
+             std::initializer_list<Napi::Value> keep)
+      : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)),
+        work(std::move(work)) {
+    for (auto &value : keep)
+      references.push_back(Napi::Persistent(value.As<Napi::Object>()));
+  }
+  void Execute() override { result = work(); }
+  void OnOK() override {
+    deferred.Resolve(Napi::Number::New(Env(), result));
+  }
+  void OnError(const Napi::Error &error) override {
+    deferred.Reject(error.Value());
+  }
+  Napi::Promise Promise() const { return deferred.Promise(); }
+
+private:
+  Napi::Promise::Deferred deferred;
+  std::function<uint8_t()> work;
+  std::vector<Napi::ObjectReference> references;
+  uint8_t result = 0;
+};
+
+// bytes per pixel of the 8 bit color types, 0 for anything else
+size_t pixelTypeSize(const std::string &type) {
+  if (type == "rgb")
+    return 3;
+  if (type == "rgba" || type == "bgra")
+    return 4;
+  return 0;
+}
+
+// queues the worker and returns its promise
+Napi::Value queueTask(Napi::Env env, std::function<uint8_t()> work,
+                      std::initializer_list<Napi::Value> keep) {
+  TaskWorker *worker = new TaskWorker(env, std::move(work), keep);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
 Napi::Value MoveBufferToImage(const Napi::CallbackInfo &info) {
   Napi::Env env = info.Env();
   if (info.Length() < 4) {
@@ -156,10 +339,13 @@ Napi::Value MoveBufferToImage(const Napi::CallbackInfo &info) {
   auto &instances = node_state_g->instances;
   if (!instances.count(index))
     return Napi::Number::New(env, 1);
-  Napi::Buffer<uint8_t> buffer = info[1].As<Napi::Buffer<uint8_t>>();
+  // scalar images come in as Float32Array or Uint16Array
+  uint8_t *buffer = typedArrayData(info[1]);
+  if (!buffer)
+    return Napi::Number::New(env, 1);
   int32_t buffer_w = info[2].As<Napi::Number>();
   int32_t buffer_h = info[3].As<Napi::Number>();
-  move_buffer_to_image(instances[index], buffer.Data(), buffer_w, buffer_h);
+  move_buffer_to_image(instances[index], buffer, buffer_w, buffer_h);
   return Napi::Number::New(env, 0);
 }
 Napi::Value DisposeInstance(const Napi::CallbackInfo &info) {
@@ -182,13 +368,15 @@ Napi::Value DisposeInstance(const Napi::CallbackInfo &info) {
               &node_state_g->mousePositionCallbacks,
               &node_state_g->textCallbacks,
               &node_state_g->windowFocusCallbacks,
-              &node_state_g->windowCloseCallbacks};
+              &node_state_g->windowCloseCallbacks,
+              &node_state_g->panelMouseCallbacks};
   for (auto *e : maps) {
     if (e->count(instance)) {
       (*e)[instance].Unref();
       e->erase(instance);
     }
   }
+  forgetEvents(instance);
   dispose_instance(instance);
   instances.erase(index);
   return Napi::Number::New(env, 0);
@@ -288,7 +476,7 @@ Napi::Value SetFrameBufferCallback(const Napi::CallbackInfo &info) {
     return Napi::Number::New(env, 1);
   Napi::Function callback = info[1].As<Napi::Function>();
   push_callback(node_state_g->frameBufferCallbacks, instances[index], callback);
-  set_text_callback(instances[index], (void *)&naa_text_cb);
+  set_framebuffer_callback(instances[index], (void *)&naa_fb_cb);
   return Napi::Number::New(env, 0);
 }
 Napi::Value SetMousePositionCallback(const Napi::CallbackInfo &info) {
@@ -423,15 +611,1431 @@ Napi::Value SetClipboard(const Napi::CallbackInfo &info) {
   return env.Null();
 }
 
-static Napi::Object Init(Napi::Env env, Napi::Object exports) {
-  if (node_state_g == nullptr)
-    node_state_g = new NodeState();
+template <typename T> uint32_t clampLength(Napi::TypedArrayOf<T> &array,
+                                           const Napi::Value &len) {
+  uint32_t requested = len.As<Napi::Number>();
+  return requested > array.ElementLength() ? array.ElementLength() : requested;
+}
+
+Napi::Value RangeF32(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float32Array in = info[0].As<Napi::Float32Array>();
+  Napi::Float64Array state = info[2].As<Napi::Float64Array>();
+  range_f32(in.Data(), clampLength(in, info[1]), state.Data());
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value RangeF64(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float64Array in = info[0].As<Napi::Float64Array>();
+  Napi::Float64Array state = info[2].As<Napi::Float64Array>();
+  range_f64(in.Data(), clampLength(in, info[1]), state.Data());
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value MapRangeF32(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float32Array in = info[0].As<Napi::Float32Array>();
+  Napi::Float32Array out = info[1].As<Napi::Float32Array>();
+  uint32_t len = clampLength(in, info[2]);
+  if (len > out.ElementLength())
+    len = out.ElementLength();
+  double lowest = info[3].As<Napi::Number>();
+  double highest = info[4].As<Napi::Number>();
+  double *state = info[5].IsTypedArray()
+                      ? info[5].As<Napi::Float64Array>().Data()
+                      : nullptr;
+  map_range_f32(in.Data(), out.Data(), len, lowest, highest, state);
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value MapRangeF64(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float64Array in = info[0].As<Napi::Float64Array>();
+  Napi::Float64Array out = info[1].As<Napi::Float64Array>();
+  uint32_t len = clampLength(in, info[2]);
+  if (len > out.ElementLength())
+    len = out.ElementLength();
+  double lowest = info[3].As<Napi::Number>();
+  double highest = info[4].As<Napi::Number>();
+  double *state = info[5].IsTypedArray()
+                      ? info[5].As<Napi::Float64Array>().Data()
+                      : nullptr;
+  map_range_f64(in.Data(), out.Data(), len, lowest, highest, state);
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value NiceTicks(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  double lowest = info[0].As<Napi::Number>();
+  double highest = info[1].As<Napi::Number>();
+  uint32_t target = info[2].As<Napi::Number>();
+  Napi::Float64Array out = info[3].As<Napi::Float64Array>();
+  uint32_t count =
+      nice_ticks(lowest, highest, target, out.Data(), clampLength(out, info[4]));
+  return Napi::Number::New(env, count);
+}
+
+SeriesStore *getSeries(const Napi::Value &value) {
+  int32_t index = value.As<Napi::Number>();
+  auto &series = node_state_g->series;
+  if (!series.count(index))
+    return nullptr;
+  return series[index];
+}
+
+Napi::Value CreateSeriesStore(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint32_t capacity = info[0].As<Napi::Number>();
+  uint32_t channels = info[1].As<Napi::Number>();
+  uint32_t is_double = info[2].As<Napi::Number>();
+  SeriesStore *store = create_series_store(capacity, channels, is_double);
+  if (!store)
+    return env.Null();
+  auto index = node_state_g->series_idx++;
+  node_state_g->series[index] = store;
+  return Napi::Number::New(env, (double)index);
+}
+
+Napi::Value DisposeSeriesStore(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  SeriesStore *store = getSeries(info[0]);
+  if (!store)
+    return Napi::Number::New(env, 1);
+  int32_t index = info[0].As<Napi::Number>();
+  node_state_g->series.erase(index);
+  dispose_series_store(store);
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value SeriesAppend(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  SeriesStore *store = getSeries(info[0]);
+  if (!store || !info[2].IsTypedArray())
+    return Napi::Number::New(env, 1);
+  Napi::TypedArray values = info[2].As<Napi::TypedArray>();
+  size_t sample_size =
+      store->channels * (store->is_double ? sizeof(double) : sizeof(float));
+  uint32_t count = info[3].As<Napi::Number>();
+  if (count > values.ByteLength() / sample_size)
+    count = values.ByteLength() / sample_size;
+  series_append(store, (double *)typedArrayData(info[1]),
+                typedArrayData(info[2]), count);
+  return Napi::Number::New(env, 0);
+}
+
+Napi::Value SeriesSetColor(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  SeriesStore *store = getSeries(info[0]);
+  if (!store)
+    return Napi::Number::New(env, 1);
+  uint32_t channel = info[1].As<Napi::Number>();
+  int32_t r = info[2].As<Napi::Number>();
+  int32_t g = info[3].As<Napi::Number>();
+  int32_t b = info[4].As<Napi::Number>();
+  return Napi::Number::New(env, series_set_color(store, channel, r, g, b));
+}
+
+Napi::Value SeriesRead(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  SeriesStore *store = getSeries(info[0]);
+  if (!store)
+    return Napi::Number::New(env, 0);
+  uint32_t channel = info[1].As<Napi::Number>();
+  uint32_t max = info[2].As<Napi::Number>();
+  for (size_t i = 3; i < 5; i++) {
+    if (info[i].IsTypedArray()) {
+      size_t len = info[i].As<Napi::Float64Array>().ElementLength();
+      if (max > len)
+        max = len;
+    }
+  }
+  uint32_t count =
+      series_read(store, channel, max, (double *)typedArrayData(info[3]),
+                  (double *)typedArrayData(info[4]));
+  return Napi::Number::New(env, count);
+}
+
+Napi::Value SeriesRenderScroll(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int32_t index = info[0].As<Napi::Number>();
+  auto &instances = node_state_g->instances;
+  SeriesStore *store = getSeries(info[1]);
+  if (!instances.count(index) || !store)
+    return Napi::Number::New(env, 1);
+  double y_min = info[2].As<Napi::Number>();
+  double y_max = info[3].As<Napi::Number>();
+  uint32_t spc = info[4].As<Napi::Number>();
+  return Napi::Number::New(
+      env, series_render_scroll(instances[index], store, y_min, y_max, spc));
+}
+
+UiInstance *getInstance(const Napi::Value &value) {
+  int32_t index = value.As<Napi::Number>();
+  auto &instances = node_state_g->instances;
+  if (!instances.count(index))
+    return nullptr;
+  return instances[index];
+}
+
+Napi::Value AddLineSeries(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  uint32_t capacity = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, add_line_series(instance, capacity));
+}
+
+Napi::Value RemoveLineSeries(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_line_series(instance, id));
+}
+
+Napi::Value LineSeriesAppend(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  Napi::Float32Array points = info[2].As<Napi::Float32Array>();
+  uint32_t count = info[3].As<Napi::Number>();
+  if (count > points.ElementLength() / 2)
+    count = points.ElementLength() / 2;
+  return Napi::Number::New(
+      env, line_series_append(instance, id, points.Data(), count));
+}
+
+Napi::Value LineSeriesClear(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, line_series_clear(instance, id));
+}
+
+Napi::Value LineSeriesStyle(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 7) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t r = info[2].As<Napi::Number>();
+  int32_t g = info[3].As<Napi::Number>();
+  int32_t b = info[4].As<Napi::Number>();
+  int32_t a = info[5].As<Napi::Number>();
+  float width = info[6].As<Napi::Number>();
+  return Napi::Number::New(env,
+                           line_series_style(instance, id, r, g, b, a, width));
+}
+
+Napi::Value SetLineRange(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  float x_min = info[1].As<Napi::Number>();
+  float x_max = info[2].As<Napi::Number>();
+  float y_min = info[3].As<Napi::Number>();
+  float y_max = info[4].As<Napi::Number>();
+  return Napi::Number::New(env,
+                           set_line_range(instance, x_min, x_max, y_min, y_max));
+}
+
+Napi::Value SetLineArea(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  float x = info[1].As<Napi::Number>();
+  float y = info[2].As<Napi::Number>();
+  float w = info[3].As<Napi::Number>();
+  float h = info[4].As<Napi::Number>();
+  return Napi::Number::New(env, set_line_area(instance, x, y, w, h));
+}
+
+Napi::Value AddScatterSet(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  uint32_t capacity = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, add_scatter_set(instance, capacity));
+}
+
+Napi::Value RemoveScatterSet(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_scatter_set(instance, id));
+}
+
+Napi::Value ScatterAppend(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  Napi::Float32Array points = info[2].As<Napi::Float32Array>();
+  uint32_t count = info[3].As<Napi::Number>();
+  if (count > points.ElementLength() / 4)
+    count = points.ElementLength() / 4;
+  return Napi::Number::New(env,
+                           scatter_append(instance, id, points.Data(), count));
+}
+
+Napi::Value ScatterClear(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, scatter_clear(instance, id));
+}
+
+Napi::Value ScatterSetPalette(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  Napi::Buffer<uint8_t> rgba = info[2].As<Napi::Buffer<uint8_t>>();
+  uint32_t count = info[3].As<Napi::Number>();
+  if (count > rgba.Length() / 4)
+    count = rgba.Length() / 4;
+  return Napi::Number::New(
+      env, scatter_set_palette(instance, id, rgba.Data(), count));
+}
+
+Napi::Value ScatterSetDensity(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t enabled = info[2].As<Napi::Number>();
+  float scale = info[3].As<Napi::Number>();
+  return Napi::Number::New(
+      env, scatter_set_density(instance, id, enabled != 0, scale));
+}
+
+Napi::Value SetColormap(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  Napi::Buffer<uint8_t> rgba = info[1].As<Napi::Buffer<uint8_t>>();
+  uint32_t count = info[2].As<Napi::Number>();
+  if (count > rgba.Length() / 4)
+    count = rgba.Length() / 4;
+  return Napi::Number::New(env, set_colormap(instance, rgba.Data(), count));
+}
+
+Napi::Value SetPalette(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  Napi::Buffer<uint8_t> rgba = info[1].As<Napi::Buffer<uint8_t>>();
+  uint32_t first = info[2].As<Napi::Number>();
+  uint32_t count = info[3].As<Napi::Number>();
+  if (count > rgba.Length() / 4)
+    count = rgba.Length() / 4;
+  return Napi::Number::New(env,
+                           set_palette(instance, rgba.Data(), first, count));
+}
+
+Napi::Value SetScalarRange(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  float min = info[1].As<Napi::Number>();
+  float max = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_scalar_range(instance, min, max));
+}
+
+Napi::Value SetWindowLevel(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  float window = info[1].As<Napi::Number>();
+  float level = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_window_level(instance, window, level));
+}
+
+Napi::Value SetView(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  float x = info[1].As<Napi::Number>();
+  float y = info[2].As<Napi::Number>();
+  float w = info[3].As<Napi::Number>();
+  float h = info[4].As<Napi::Number>();
+  return Napi::Number::New(env, set_view(instance, x, y, w, h));
+}
+
+Napi::Value SetMipmaps(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t enabled = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, set_mipmaps(instance, enabled != 0));
+}
+
+Napi::Value RequestRender(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, request_render(instance));
+}
+
+Napi::Value RenderAll(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  return Napi::Number::New(env, render_all());
+}
+
+Napi::Value AddFont(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  float ascent = info[0].As<Napi::Number>();
+  float descent = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, add_font(ascent, descent));
+}
+
+Napi::Value AtlasAddGlyph(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 9) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  // without a window only the cpu copy of the atlas is updated
+  UiInstance *instance = getInstance(info[0]);
+  uint32_t font = info[1].As<Napi::Number>();
+  uint32_t codepoint = info[2].As<Napi::Number>();
+  // blank glyphs come without a bitmap
+  uint8_t *alpha = typedArrayData(info[3]);
+  uint32_t w = info[4].As<Napi::Number>();
+  uint32_t h = info[5].As<Napi::Number>();
+  if (!alpha && w && h)
+    return Napi::Number::New(env, 1);
+  float bearing_x = info[6].As<Napi::Number>();
+  float bearing_y = info[7].As<Napi::Number>();
+  float advance = info[8].As<Napi::Number>();
+  return Napi::Number::New(env,
+                           atlas_add_glyph(instance, font, codepoint, alpha, w,
+                                           h, bearing_x, bearing_y, advance));
+}
+
+Napi::Value AddText(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  return Napi::Number::New(env, add_text(instance));
+}
+
+Napi::Value RemoveText(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_text(instance, id));
+}
+
+Napi::Value SetText(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 9) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance || !info[3].IsTypedArray())
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  uint32_t font = info[2].As<Napi::Number>();
+  Napi::Uint32Array codepoints = info[3].As<Napi::Uint32Array>();
+  uint32_t count = clampLength(codepoints, info[4]);
+  float x = info[5].As<Napi::Number>();
+  float y = info[6].As<Napi::Number>();
+  uint32_t align = info[7].As<Napi::Number>();
+  uint32_t baseline = info[8].As<Napi::Number>();
+  return Napi::Number::New(env, set_text(instance, id, font, codepoints.Data(),
+                                         count, x, y, align, baseline));
+}
+
+Napi::Value SetTextStyle(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  uint32_t r = info[2].As<Napi::Number>();
+  uint32_t g = info[3].As<Napi::Number>();
+  uint32_t b = info[4].As<Napi::Number>();
+  uint32_t a = info[5].As<Napi::Number>();
+  return Napi::Number::New(env, set_text_style(instance, id, r, g, b, a));
+}
+
+Napi::Value SetTextVisible(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t visible = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_text_visible(instance, id, visible != 0));
+}
+
+Napi::Value ExecuteCommands(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *commands = typedArrayData(info[1]);
+  if (!instance || !commands)
+    return Napi::Number::New(env, 1);
+  Napi::TypedArray array = info[1].As<Napi::TypedArray>();
+  uint32_t length = info[2].As<Napi::Number>();
+  if (length > array.ByteLength())
+    length = array.ByteLength();
+  return Napi::Number::New(env, execute_commands(instance, commands, length));
+}
+
+Napi::Value AddSceneNode(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  int32_t z = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, add_scene_node(instance, z));
+}
+
+Napi::Value RemoveSceneNode(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_scene_node(instance, id));
+}
+
+Napi::Value SetSceneNode(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *commands = typedArrayData(info[2]);
+  if (!instance || !commands)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  Napi::TypedArray array = info[2].As<Napi::TypedArray>();
+  uint32_t length = info[3].As<Napi::Number>();
+  if (length > array.ByteLength())
+    length = array.ByteLength();
+  return Napi::Number::New(env, set_scene_node(instance, id, commands, length));
+}
+
+Napi::Value SetSceneNodeOffset(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  float x = info[2].As<Napi::Number>();
+  float y = info[3].As<Napi::Number>();
+  return Napi::Number::New(env, set_scene_node_offset(instance, id, x, y));
+}
+
+Napi::Value SetSceneNodeVisible(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t visible = info[2].As<Napi::Number>();
+  return Napi::Number::New(env,
+                           set_scene_node_visible(instance, id, visible != 0));
+}
+
+Napi::Value SetSceneNodeZ(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t z = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_scene_node_z(instance, id, z));
+}
+
+Napi::Value SetSceneBackground(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  uint32_t r = info[1].As<Napi::Number>();
+  uint32_t g = info[2].As<Napi::Number>();
+  uint32_t b = info[3].As<Napi::Number>();
+  uint32_t a = info[4].As<Napi::Number>();
+  return Napi::Number::New(env, set_scene_background(instance, r, g, b, a));
+}
+
+Napi::Value GetSceneDrawnPixels(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 0);
+  return Napi::Number::New(env, get_scene_drawn_pixels(instance));
+}
+
+Napi::Value SetThreadCount(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint32_t count = info[0].As<Napi::Number>();
+  return Napi::Number::New(env, set_thread_count(count));
+}
+
+Napi::Value GetThreadCount(const Napi::CallbackInfo &info) {
+  return Napi::Number::New(info.Env(), get_thread_count());
+}
+
+Napi::Value ConvertPixels(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 7) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint8_t *src = typedArrayData(info[0]);
+  uint8_t *dst = typedArrayData(info[2]);
+  if (!src || !dst || !info[1].IsString() || !info[3].IsString())
+    return Napi::Number::New(env, 1);
+  std::string from = info[1].As<Napi::String>();
+  std::string to = info[3].As<Napi::String>();
+  uint32_t w = info[4].As<Napi::Number>();
+  uint32_t h = info[5].As<Napi::Number>();
+  uint64_t pixels = (uint64_t)w * h;
+  // premultiplied types are conversion only, the sizes match their base type
+  size_t from_size = pixelTypeSize(from.substr(0, from.find("_premul")));
+  size_t to_size = pixelTypeSize(to.substr(0, to.find("_premul")));
+  if (!from_size || !to_size ||
+      info[0].As<Napi::TypedArray>().ByteLength() < pixels * from_size ||
+      info[2].As<Napi::TypedArray>().ByteLength() < pixels * to_size)
+    return Napi::Number::New(env, 1);
+  auto work = [=]() {
+    return convert_pixels(src, from.c_str(), dst, to.c_str(), w, h);
+  };
+  // the last argument picks the promise variant
+  if (info[6].ToBoolean())
+    return queueTask(env, work, {info[0], info[2]});
+  return Napi::Number::New(env, work());
+}
+
+Napi::Value GetUploadStats(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float64Array out = info[0].As<Napi::Float64Array>();
+  if (out.ElementLength() < 9)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, get_upload_stats(out.Data()));
+}
+
+Napi::Value GetImageTypeInfo(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (!info[0].IsString())
+    return Napi::Number::New(env, 1);
+  std::string type = info[0].As<Napi::String>();
+  Napi::Int32Array out = info[1].As<Napi::Int32Array>();
+  if (out.ElementLength() < 4)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, get_image_type_info(type.c_str(), out.Data()));
+}
+
+Napi::Value SetConvertSimd(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint8_t enabled = info[0].ToBoolean();
+  return Napi::Number::New(env, set_convert_simd(enabled));
+}
+
+Napi::Value GetConvertKernel(const Napi::CallbackInfo &info) {
+  return Napi::Number::New(info.Env(), get_convert_kernel());
+}
+
+Napi::Value DecimateMinmax(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint8_t *values = typedArrayData(info[0]);
+  uint8_t *out = typedArrayData(info[4]);
+  if (!values || !out)
+    return Napi::Number::New(env, 1);
+  uint8_t is_double = info[1].As<Napi::Number>().Uint32Value() != 0;
+  uint32_t count = info[2].As<Napi::Number>();
+  uint32_t buckets = info[3].As<Napi::Number>();
+  const uint64_t size = is_double ? sizeof(double) : sizeof(float);
+  // in 64 bits, a 32 bit product wraps for large bucket counts
+  const uint64_t out_size = (uint64_t)buckets * 2 * size;
+  if (info[0].As<Napi::TypedArray>().ByteLength() < count * size ||
+      info[4].As<Napi::TypedArray>().ByteLength() < out_size)
+    return Napi::Number::New(env, 1);
+  auto work = [=]() {
+    return decimate_minmax(values, is_double, count, buckets, out);
+  };
+  if (info[5].ToBoolean())
+    return queueTask(env, work, {info[0], info[4]});
+  return Napi::Number::New(env, work());
+}
+
+Napi::Value RasterizeCommands(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 7) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint8_t *pixels = typedArrayData(info[0]);
+  uint8_t *commands = typedArrayData(info[4]);
+  if (!pixels || !commands || !info[3].IsString())
+    return Napi::Number::New(env, 1);
+  uint32_t w = info[1].As<Napi::Number>();
+  uint32_t h = info[2].As<Napi::Number>();
+  std::string type = info[3].As<Napi::String>();
+  uint32_t length = info[5].As<Napi::Number>();
+  Napi::TypedArray array = info[4].As<Napi::TypedArray>();
+  if (length > array.ByteLength())
+    length = array.ByteLength();
+  if (!pixelTypeSize(type) || info[0].As<Napi::TypedArray>().ByteLength() <
+                                  (uint64_t)w * h * pixelTypeSize(type))
+    return Napi::Number::New(env, 1);
+  auto work = [=]() {
+    return rasterize_commands(pixels, w, h, type.c_str(), commands, length);
+  };
+  if (info[6].ToBoolean())
+    return queueTask(env, work, {info[0], info[4]});
+  return Napi::Number::New(env, work());
+}
+
+Napi::Value MoveBufferRegionToImage(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 7) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *source = typedArrayData(info[1]);
+  if (!instance || !source)
+    return Napi::Number::New(env, 1);
+  uint32_t stride = info[2].As<Napi::Number>();
+  uint32_t x = info[3].As<Napi::Number>();
+  uint32_t y = info[4].As<Napi::Number>();
+  uint32_t w = info[5].As<Napi::Number>();
+  uint32_t h = info[6].As<Napi::Number>();
+  // the last row only has to reach the end of the region, not the stride
+  uint64_t end = ((uint64_t)(y + h - 1) * stride + x + w) *
+                 get_buffer_pixel_size(&instance->render_buffer);
+  if (w == 0 || h == 0 ||
+      info[1].As<Napi::TypedArray>().ByteLength() < end)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(
+      env, move_buffer_region_to_image(instance, source, stride, x, y, w, h));
+}
+
+Napi::Value Prewarm(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int32_t threaded = info[0].As<Napi::Number>();
+  return Napi::Number::New(env, prewarm(threaded != 0));
+}
+
+Napi::Value GetStartupTimings(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Float64Array out = info[0].As<Napi::Float64Array>();
+  if (out.ElementLength() < STARTUP_TIMING_COUNT)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, get_startup_timings(out.Data()));
+}
+
+Napi::Value SetProgramCacheDir(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString())
+    return Napi::Number::New(env, set_program_cache_dir(NULL));
+  std::string path = info[0].As<Napi::String>();
+  return Napi::Number::New(env, set_program_cache_dir(path.c_str()));
+}
+
+Napi::Value AddLayer(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  int32_t z = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, add_layer(instance, z));
+}
+
+Napi::Value RemoveLayer(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_layer(instance, id));
+}
+
+Napi::Value UpdateLayer(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *buffer = typedArrayData(info[2]);
+  if (!instance || !buffer)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  uint32_t w = info[3].As<Napi::Number>();
+  uint32_t h = info[4].As<Napi::Number>();
+  Layer *layer = get_layer(instance, id);
+  if (!layer || info[2].As<Napi::TypedArray>().ByteLength() <
+                    (uint64_t)w * h * get_buffer_pixel_size(&layer->image))
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, update_layer(instance, id, buffer, w, h));
+}
+
+Napi::Value SetLayerColorType(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  std::string type = info[2].As<Napi::String>();
+  return Napi::Number::New(env,
+                           set_layer_color_type(instance, id, type.c_str()));
+}
+
+Napi::Value SetLayerVisible(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t visible = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_layer_visible(instance, id, visible != 0));
+}
+
+Napi::Value SetLayerZ(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t z = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_layer_z(instance, id, z));
+}
+
+Napi::Value SetLayerAlpha(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  float alpha = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_layer_alpha(instance, id, alpha));
+}
+
+Napi::Value AddPanel(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, -1);
+  return Napi::Number::New(env, add_panel(instance));
+}
+
+Napi::Value RemovePanel(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, remove_panel(instance, id));
+}
+
+Napi::Value UpdatePanel(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 5) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *buffer = typedArrayData(info[2]);
+  if (!instance || !buffer)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  uint32_t w = info[3].As<Napi::Number>();
+  uint32_t h = info[4].As<Napi::Number>();
+  Panel *panel = get_panel(instance, id);
+  if (!panel || info[2].As<Napi::TypedArray>().ByteLength() <
+                    (uint64_t)w * h * get_buffer_pixel_size(&panel->image))
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, update_panel(instance, id, buffer, w, h));
+}
+
+Napi::Value SetPanelColorType(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  std::string type = info[2].As<Napi::String>();
+  return Napi::Number::New(env,
+                           set_panel_color_type(instance, id, type.c_str()));
+}
+
+Napi::Value SetPanelRect(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  float x = info[2].As<Napi::Number>();
+  float y = info[3].As<Napi::Number>();
+  float w = info[4].As<Napi::Number>();
+  float h = info[5].As<Napi::Number>();
+  return Napi::Number::New(env, set_panel_rect(instance, id, x, y, w, h));
+}
+
+Napi::Value SetPanelVisible(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  int32_t id = info[1].As<Napi::Number>();
+  int32_t visible = info[2].As<Napi::Number>();
+  return Napi::Number::New(env, set_panel_visible(instance, id, visible != 0));
+}
+
+Napi::Value SetPanelGrid(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  uint32_t cols = info[1].As<Napi::Number>();
+  uint32_t rows = info[2].As<Napi::Number>();
+  float gap = info[3].As<Napi::Number>();
+  return Napi::Number::New(env, set_panel_grid(instance, cols, rows, gap));
+}
+
+Napi::Value SetPanelMouseCallback(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  Napi::Function callback = info[1].As<Napi::Function>();
+  push_callback(node_state_g->panelMouseCallbacks, instance, callback);
+  return Napi::Number::New(
+      env, set_panel_mouse_callback(instance, (void *)&naa_panel_mouse_cb));
+}
+
+Napi::Value SetTiledImage(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  uint32_t w = info[1].As<Napi::Number>();
+  uint32_t h = info[2].As<Napi::Number>();
+  uint32_t tile_size = info[3].As<Napi::Number>();
+  return Napi::Number::New(env, set_tiled_image(instance, w, h, tile_size));
+}
+
+Napi::Value TiledImageWrite(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 6) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *data = typedArrayData(info[1]);
+  if (!instance || !instance->tiled || !data)
+    return Napi::Number::New(env, 1);
+  uint32_t x = info[2].As<Napi::Number>();
+  uint32_t y = info[3].As<Napi::Number>();
+  uint32_t w = info[4].As<Napi::Number>();
+  uint32_t h = info[5].As<Napi::Number>();
+  size_t needed =
+      (size_t)w * h * get_buffer_pixel_size(&instance->tiled->source);
+  if (info[1].As<Napi::TypedArray>().ByteLength() < needed)
+    return Napi::Number::New(env, 1);
+  return Napi::Number::New(env, tiled_image_write(instance, data, x, y, w, h));
+}
+
+Napi::Value SetTileBudget(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 2) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  uint32_t megabytes = info[1].As<Napi::Number>();
+  return Napi::Number::New(env, set_tile_budget(instance, megabytes));
+}
+
+Napi::Value SetWaterfall(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  if (!instance)
+    return Napi::Number::New(env, 1);
+  uint32_t w = info[1].As<Napi::Number>();
+  uint32_t rows = info[2].As<Napi::Number>();
+  int32_t newest_on_top = info[3].As<Napi::Number>();
+  return Napi::Number::New(
+      env, set_waterfall(instance, w, rows, newest_on_top != 0));
+}
+
+Napi::Value WaterfallPushRows(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3) {
+    Napi::TypeError::New(env, "Wrong number of arguments")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  UiInstance *instance = getInstance(info[0]);
+  uint8_t *rows = typedArrayData(info[1]);
+  if (!instance || !rows)
+    return Napi::Number::New(env, 1);
+  Image *image = &instance->render_buffer;
+  uint32_t count = info[2].As<Napi::Number>();
+  size_t row_size = (size_t)image->w * get_buffer_pixel_size(image);
+  size_t length = info[1].As<Napi::TypedArray>().ByteLength();
+  if (row_size == 0)
+    return Napi::Number::New(env, 1);
+  if (count > length / row_size)
+    count = length / row_size;
+  return Napi::Number::New(env, waterfall_push_rows(instance, rows, count));
+}
+
+static Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  if (node_state_g == nullptr) {
+    node_state_g = new NodeState();
+    // the drain does all the work, the function only satisfies N-API 4;
+    // unref'd so pending input never keeps the process alive on its own
+    node_state_g->events = Napi::ThreadSafeFunction::New(
+        env, Napi::Function::New(env, IgnoreEvent),
+        "bun-ui events", 0, 1);
+    node_state_g->events.Unref(env);
+  }
   exports.Set(Napi::String::New(env, "create_window"),
               Napi::Function::New(env, CreateInstance));
   exports.Set(Napi::String::New(env, "render_window"),
               Napi::Function::New(env, RenderWindow));
+  exports.Set(Napi::String::New(env, "request_render"),
+              Napi::Function::New(env, RequestRender));
+  exports.Set(Napi::String::New(env, "render_all"),
+              Napi::Function::New(env, RenderAll));
+  exports.Set(Napi::String::New(env, "set_program_cache_dir"),
+              Napi::Function::New(env, SetProgramCacheDir));
+  exports.Set(Napi::String::New(env, "prewarm"),
+              Napi::Function::New(env, Prewarm));
+  exports.Set(Napi::String::New(env, "get_startup_timings"),
+              Napi::Function::New(env, GetStartupTimings));
+  exports.Set(Napi::String::New(env, "add_font"),
+              Napi::Function::New(env, AddFont));
+  exports.Set(Napi::String::New(env, "atlas_add_glyph"),
+              Napi::Function::New(env, AtlasAddGlyph));
+  exports.Set(Napi::String::New(env, "add_text"),
+              Napi::Function::New(env, AddText));
+  exports.Set(Napi::String::New(env, "remove_text"),
+              Napi::Function::New(env, RemoveText));
+  exports.Set(Napi::String::New(env, "set_text"),
+              Napi::Function::New(env, SetText));
+  exports.Set(Napi::String::New(env, "set_text_style"),
+              Napi::Function::New(env, SetTextStyle));
+  exports.Set(Napi::String::New(env, "set_text_visible"),
+              Napi::Function::New(env, SetTextVisible));
+  exports.Set(Napi::String::New(env, "execute_commands"),
+              Napi::Function::New(env, ExecuteCommands));
+  exports.Set(Napi::String::New(env, "add_scene_node"),
+              Napi::Function::New(env, AddSceneNode));
+  exports.Set(Napi::String::New(env, "remove_scene_node"),
+              Napi::Function::New(env, RemoveSceneNode));
+  exports.Set(Napi::String::New(env, "set_scene_node"),
+              Napi::Function::New(env, SetSceneNode));
+  exports.Set(Napi::String::New(env, "set_scene_node_offset"),
+              Napi::Function::New(env, SetSceneNodeOffset));
+  exports.Set(Napi::String::New(env, "set_scene_node_visible"),
+              Napi::Function::New(env, SetSceneNodeVisible));
+  exports.Set(Napi::String::New(env, "set_scene_node_z"),
+              Napi::Function::New(env, SetSceneNodeZ));
+  exports.Set(Napi::String::New(env, "set_scene_background"),
+              Napi::Function::New(env, SetSceneBackground));
+  exports.Set(Napi::String::New(env, "get_scene_drawn_pixels"),
+              Napi::Function::New(env, GetSceneDrawnPixels));
+  exports.Set(Napi::String::New(env, "set_thread_count"),
+              Napi::Function::New(env, SetThreadCount));
+  exports.Set(Napi::String::New(env, "get_thread_count"),
+              Napi::Function::New(env, GetThreadCount));
+  exports.Set(Napi::String::New(env, "convert_pixels"),
+              Napi::Function::New(env, ConvertPixels));
+  exports.Set(Napi::String::New(env, "set_convert_simd"),
+              Napi::Function::New(env, SetConvertSimd));
+  exports.Set(Napi::String::New(env, "get_convert_kernel"),
+              Napi::Function::New(env, GetConvertKernel));
+  exports.Set(Napi::String::New(env, "get_image_type_info"),
+              Napi::Function::New(env, GetImageTypeInfo));
+  exports.Set(Napi::String::New(env, "get_upload_stats"),
+              Napi::Function::New(env, GetUploadStats));
+  exports.Set(Napi::String::New(env, "decimate_minmax"),
+              Napi::Function::New(env, DecimateMinmax));
+  exports.Set(Napi::String::New(env, "rasterize_commands"),
+              Napi::Function::New(env, RasterizeCommands));
   exports.Set(Napi::String::New(env, "move_buffer_to_image"),
               Napi::Function::New(env, MoveBufferToImage));
+  exports.Set(Napi::String::New(env, "move_buffer_region_to_image"),
+              Napi::Function::New(env, MoveBufferRegionToImage));
   exports.Set(Napi::String::New(env, "dispose_instance"),
               Napi::Function::New(env, DisposeInstance));
   exports.Set(Napi::String::New(env, "update_title"),
@@ -462,6 +2066,106 @@ static Napi::Object Init(Napi::Env env, Napi::Object exports) {
               Napi::Function::New(env, GetClipboard));
   exports.Set(Napi::String::New(env, "set_clipboard"),
               Napi::Function::New(env, SetClipboard));
+  exports.Set(Napi::String::New(env, "range_f32"),
+              Napi::Function::New(env, RangeF32));
+  exports.Set(Napi::String::New(env, "range_f64"),
+              Napi::Function::New(env, RangeF64));
+  exports.Set(Napi::String::New(env, "map_range_f32"),
+              Napi::Function::New(env, MapRangeF32));
+  exports.Set(Napi::String::New(env, "map_range_f64"),
+              Napi::Function::New(env, MapRangeF64));
+  exports.Set(Napi::String::New(env, "nice_ticks"),
+              Napi::Function::New(env, NiceTicks));
+  exports.Set(Napi::String::New(env, "create_series_store"),
+              Napi::Function::New(env, CreateSeriesStore));
+  exports.Set(Napi::String::New(env, "dispose_series_store"),
+              Napi::Function::New(env, DisposeSeriesStore));
+  exports.Set(Napi::String::New(env, "series_append"),
+              Napi::Function::New(env, SeriesAppend));
+  exports.Set(Napi::String::New(env, "series_set_color"),
+              Napi::Function::New(env, SeriesSetColor));
+  exports.Set(Napi::String::New(env, "series_read"),
+              Napi::Function::New(env, SeriesRead));
+  exports.Set(Napi::String::New(env, "series_render_scroll"),
+              Napi::Function::New(env, SeriesRenderScroll));
+  exports.Set(Napi::String::New(env, "add_line_series"),
+              Napi::Function::New(env, AddLineSeries));
+  exports.Set(Napi::String::New(env, "remove_line_series"),
+              Napi::Function::New(env, RemoveLineSeries));
+  exports.Set(Napi::String::New(env, "line_series_append"),
+              Napi::Function::New(env, LineSeriesAppend));
+  exports.Set(Napi::String::New(env, "line_series_clear"),
+              Napi::Function::New(env, LineSeriesClear));
+  exports.Set(Napi::String::New(env, "line_series_style"),
+              Napi::Function::New(env, LineSeriesStyle));
+  exports.Set(Napi::String::New(env, "set_line_range"),
+              Napi::Function::New(env, SetLineRange));
+  exports.Set(Napi::String::New(env, "set_line_area"),
+              Napi::Function::New(env, SetLineArea));
+  exports.Set(Napi::String::New(env, "set_colormap"),
+              Napi::Function::New(env, SetColormap));
+  exports.Set(Napi::String::New(env, "set_scalar_range"),
+              Napi::Function::New(env, SetScalarRange));
+  exports.Set(Napi::String::New(env, "set_window_level"),
+              Napi::Function::New(env, SetWindowLevel));
+  exports.Set(Napi::String::New(env, "set_palette"),
+              Napi::Function::New(env, SetPalette));
+  exports.Set(Napi::String::New(env, "set_view"),
+              Napi::Function::New(env, SetView));
+  exports.Set(Napi::String::New(env, "set_mipmaps"),
+              Napi::Function::New(env, SetMipmaps));
+  exports.Set(Napi::String::New(env, "add_layer"),
+              Napi::Function::New(env, AddLayer));
+  exports.Set(Napi::String::New(env, "remove_layer"),
+              Napi::Function::New(env, RemoveLayer));
+  exports.Set(Napi::String::New(env, "update_layer"),
+              Napi::Function::New(env, UpdateLayer));
+  exports.Set(Napi::String::New(env, "set_layer_color_type"),
+              Napi::Function::New(env, SetLayerColorType));
+  exports.Set(Napi::String::New(env, "set_layer_visible"),
+              Napi::Function::New(env, SetLayerVisible));
+  exports.Set(Napi::String::New(env, "set_layer_z"),
+              Napi::Function::New(env, SetLayerZ));
+  exports.Set(Napi::String::New(env, "set_layer_alpha"),
+              Napi::Function::New(env, SetLayerAlpha));
+  exports.Set(Napi::String::New(env, "add_panel"),
+              Napi::Function::New(env, AddPanel));
+  exports.Set(Napi::String::New(env, "remove_panel"),
+              Napi::Function::New(env, RemovePanel));
+  exports.Set(Napi::String::New(env, "update_panel"),
+              Napi::Function::New(env, UpdatePanel));
+  exports.Set(Napi::String::New(env, "set_panel_color_type"),
+              Napi::Function::New(env, SetPanelColorType));
+  exports.Set(Napi::String::New(env, "set_panel_rect"),
+              Napi::Function::New(env, SetPanelRect));
+  exports.Set(Napi::String::New(env, "set_panel_visible"),
+              Napi::Function::New(env, SetPanelVisible));
+  exports.Set(Napi::String::New(env, "set_panel_grid"),
+              Napi::Function::New(env, SetPanelGrid));
+  exports.Set(Napi::String::New(env, "set_panel_mouse_callback"),
+              Napi::Function::New(env, SetPanelMouseCallback));
+  exports.Set(Napi::String::New(env, "set_tiled_image"),
+              Napi::Function::New(env, SetTiledImage));
+  exports.Set(Napi::String::New(env, "tiled_image_write"),
+              Napi::Function::New(env, TiledImageWrite));
+  exports.Set(Napi::String::New(env, "set_tile_budget"),
+              Napi::Function::New(env, SetTileBudget));
+  exports.Set(Napi::String::New(env, "set_waterfall"),
+              Napi::Function::New(env, SetWaterfall));
+  exports.Set(Napi::String::New(env, "waterfall_push_rows"),
+              Napi::Function::New(env, WaterfallPushRows));
+  exports.Set(Napi::String::New(env, "add_scatter_set"),
+              Napi::Function::New(env, AddScatterSet));
+  exports.Set(Napi::String::New(env, "remove_scatter_set"),
+              Napi::Function::New(env, RemoveScatterSet));
+  exports.Set(Napi::String::New(env, "scatter_append"),
+              Napi::Function::New(env, ScatterAppend));
+  exports.Set(Napi::String::New(env, "scatter_clear"),
+              Napi::Function::New(env, ScatterClear));
+  exports.Set(Napi::String::New(env, "scatter_set_palette"),
+              Napi::Function::New(env, ScatterSetPalette));
+  exports.Set(Napi::String::New(env, "scatter_set_density"),
+              Napi::Function::New(env, ScatterSetDensity));
   return exports;
 }
 
@@ -0,0 +1,226 @@
+#include "panel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+Panel *get_panel(UiInstance *instance, int32_t id) {
+  if (id < 0 || (uint32_t)id >= instance->panel_count)
+    return NULL;
+  Panel *panel = &instance->panels[id];
+  return panel->in_use ? panel : NULL;
+}
+
+int32_t add_panel(UiInstance *instance) {
+  uint32_t id = 0;
+  while (id < instance->panel_count && instance->panels[id].in_use)
+    id++;
+  if (id == instance->panel_count) {
+    Panel *resized =
+        realloc(instance->panels, sizeof(Panel) * (instance->panel_count + 1));
+    if (!resized)
+      return -1;
+    instance->panels = resized;
+    instance->panel_count++;
+  }
+  Panel *panel = &instance->panels[id];
+  memset(panel, 0, sizeof(Panel));
+  panel->in_use = 1;
+  panel->visible = 1;
+  panel->image.type = RGBA;
+  glfwMakeContextCurrent(instance->window);
+  allocate_texture(&panel->image);
+  instance->needs_render = 1;
+  return id;
+}
+
+uint8_t remove_panel(UiInstance *instance, int32_t id) {
+  Panel *panel = get_panel(instance, id);
+  if (!panel)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  glDeleteTextures(1, &panel->image.texture_id);
+  free(panel->image.buffer);
+  memset(panel, 0, sizeof(Panel));
+  instance->needs_render = 1;
+  return 0;
+}
+
+void dispose_panels(UiInstance *instance) {
+  for (uint32_t i = 0; i < instance->panel_count; i++)
+    remove_panel(instance, i);
+  free(instance->panels);
+  instance->panels = NULL;
+  instance->panel_count = 0;
+}
+
+uint8_t update_panel(UiInstance *instance, int32_t id, const uint8_t *buffer,
+                     uint32_t w, uint32_t h) {
+  Panel *panel = get_panel(instance, id);
+  if (!panel)
+    return 1;
+  image_buffer_resize(&panel->image, w, h);
+  memcpy(panel->image.buffer, buffer, panel->image.buffer_size);
+  panel->image.dirty = 1;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_panel_color_type(UiInstance *instance, int32_t id,
+                             const char *type) {
+  Panel *panel = get_panel(instance, id);
+  if (!panel)
+    return 1;
+  instance->needs_render = 1;
+  return image_set_type(&panel->image, type);
+}
+
+uint8_t set_panel_rect(UiInstance *instance, int32_t id, float x, float y,
+                       float w, float h) {
+  Panel *panel = get_panel(instance, id);
+  if (!panel)
+    return 1;
+  // a zero size puts the panel back into the grid
+  panel->placed = w > 0 && h > 0;
+  panel->rect = vec4f(x, y, w, h);
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_panel_visible(UiInstance *instance, int32_t id, uint8_t visible) {
+  Panel *panel = get_panel(instance, id);
+  if (!panel)
+    return 1;
+  panel->visible = visible;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_panel_grid(UiInstance *instance, uint32_t cols, uint32_t rows,
+                       float gap) {
+  instance->panel_cols = cols;
+  instance->panel_rows = rows;
+  instance->panel_gap = gap < 0 ? 0 : gap;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_panel_mouse_callback(UiInstance *instance, void *callback) {
+  instance->panel_mouse_callback = callback;
+  glfwSetCursorPosCallback(instance->window, cursor_position_callback);
+  glfwSetMouseButtonCallback(instance->window, mouse_button_callback);
+  return 0;
+}
+
+// the letterboxed image inside the panel cell
+static Vec4f panel_image_rect(Panel *panel) {
+  Vec4f cell = panel->cell;
+  if (panel->image.w == 0 || panel->image.h == 0 || cell.w <= 0)
+    return vec4f(cell.x, cell.y, 0, 0);
+  float image_aspect = (float)panel->image.w / panel->image.h;
+  if (image_aspect > cell.z / cell.w) {
+    float h = cell.z / image_aspect;
+    return vec4f(cell.x, cell.y + (cell.w - h) / 2, cell.z, h);
+  }
+  float w = cell.w * image_aspect;
+  return vec4f(cell.x + (cell.z - w) / 2, cell.y, w, cell.w);
+}
+
+static void layout_panels(UiInstance *instance) {
+  const float width = instance->window_width;
+  const float height = instance->window_height;
+  uint32_t grid_count = 0;
+  for (uint32_t i = 0; i < instance->panel_count; i++) {
+    if (instance->panels[i].in_use && !instance->panels[i].placed)
+      grid_count++;
+  }
+  uint32_t cols = instance->panel_cols;
+  uint32_t rows = instance->panel_rows;
+  if (cols == 0)
+    cols = grid_count ? (uint32_t)ceil(sqrt((double)grid_count)) : 1;
+  if (rows == 0)
+    rows = grid_count ? (grid_count + cols - 1) / cols : 1;
+  const float gap = instance->panel_gap;
+  const float cell_w = (width - gap * (cols + 1)) / cols;
+  const float cell_h = (height - gap * (rows + 1)) / rows;
+  uint32_t slot = 0;
+  for (uint32_t i = 0; i < instance->panel_count; i++) {
+    Panel *panel = &instance->panels[i];
+    if (!panel->in_use)
+      continue;
+    if (panel->placed) {
+      panel->cell = vec4f(panel->rect.x * width, panel->rect.y * height,
+                          panel->rect.z * width, panel->rect.w * height);
+      continue;
+    }
+    // hidden panels keep their slot so the layout does not jump
+    if (slot >= cols * rows) {
+      panel->cell = vec4f(0, 0, 0, 0);
+      continue;
+    }
+    uint32_t x = slot % cols, y = slot / cols;
+    panel->cell = vec4f(gap + x * (cell_w + gap), gap + y * (cell_h + gap),
+                        cell_w, cell_h);
+    slot++;
+  }
+}
+
+void render_panels(UiInstance *instance) {
+  if (instance->panel_count == 0)
+    return;
+  layout_panels(instance);
+  for (uint32_t i = 0; i < instance->panel_count; i++) {
+    Panel *panel = &instance->panels[i];
+    if (!panel->in_use || !panel->visible || !panel->image.buffer)
+      continue;
+    Vec4f rect = panel_image_rect(panel);
+    if (rect.z <= 0 || rect.w <= 0)
+      continue;
+    // only panels that changed since the last frame are uploaded
+    move_image_buffer_to_texture(&panel->image);
+    Shader *shader = use_image_shader(instance, &panel->image, 1.0f);
+    shader_set4f(shader, "view", 0, 0, 1, 1);
+    glBindTexture(GL_TEXTURE_2D, panel->image.texture_id);
+    Vec2f pos = {rect.x, rect.y};
+    SimpleShaderEntry entry = {normalize(instance, pos), {rect.z, rect.w}};
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SimpleShaderEntry), &entry);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 6, 1);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int32_t panel_at(UiInstance *instance, double x, double y) {
+  // later panels are drawn on top, so they win
+  for (int32_t i = (int32_t)instance->panel_count - 1; i >= 0; i--) {
+    Panel *panel = &instance->panels[i];
+    if (!panel->in_use || !panel->visible)
+      continue;
+    Vec4f cell = panel->cell;
+    if (x >= cell.x && y >= cell.y && x < cell.x + cell.z &&
+        y < cell.y + cell.w)
+      return i;
+  }
+  return -1;
+}
+
+void route_panel_mouse(UiInstance *instance, int32_t button, int32_t action) {
+  if (!instance->panel_mouse_callback || instance->panel_count == 0)
+    return;
+  // glfw reports the cursor in screen coordinates, panels are laid out in
+  // framebuffer pixels
+  int32_t window_w, window_h;
+  glfwGetWindowSize(instance->window, &window_w, &window_h);
+  double x = instance->cursor_x, y = instance->cursor_y;
+  if (window_w > 0 && window_h > 0) {
+    x *= (double)instance->window_width / window_w;
+    y *= (double)instance->window_height / window_h;
+  }
+  int32_t id = panel_at(instance, x, y);
+  if (id < 0)
+    return;
+  Panel *panel = &instance->panels[id];
+  Vec4f rect = panel_image_rect(panel);
+  double local_x = rect.z > 0 ? (x - rect.x) / rect.z * panel->image.w : 0;
+  double local_y = rect.w > 0 ? (y - rect.y) / rect.w * panel->image.h : 0;
+  ((panel_mouse_cb_t *)instance->panel_mouse_callback)(
+      instance, id, local_x, local_y, button, action);
+}
@@ -0,0 +1,53 @@
+#ifndef PANEL_H
+#define PANEL_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Panels are independent images laid out inside one window, so many charts
+ * share a single context, draw pass and swap. Panels without an explicit
+ * rect fill the cells of the grid in id order.
+ */
+typedef struct Panel {
+  uint8_t in_use;
+  uint8_t visible;
+  uint8_t placed;
+  // fractions of the window, only used when placed
+  Vec4f rect;
+  Image image;
+  // cell of the last frame in framebuffer pixels, used for hit testing
+  Vec4f cell;
+} Panel;
+
+// button is -1 for cursor movement, x and y are in panel buffer pixels
+typedef uint8_t panel_mouse_cb_t(UiInstance *, int32_t panel, double x,
+                                 double y, int32_t button, int32_t action);
+
+int32_t add_panel(UiInstance *instance);
+uint8_t remove_panel(UiInstance *instance, int32_t id);
+// NULL for ids that are not in use
+Panel *get_panel(UiInstance *instance, int32_t id);
+uint8_t update_panel(UiInstance *instance, int32_t id, const uint8_t *buffer,
+                     uint32_t w, uint32_t h);
+uint8_t set_panel_color_type(UiInstance *instance, int32_t id,
+                             const char *type);
+uint8_t set_panel_rect(UiInstance *instance, int32_t id, float x, float y,
+                       float w, float h);
+uint8_t set_panel_visible(UiInstance *instance, int32_t id, uint8_t visible);
+uint8_t set_panel_grid(UiInstance *instance, uint32_t cols, uint32_t rows,
+                       float gap);
+uint8_t set_panel_mouse_callback(UiInstance *instance, void *callback);
+int32_t panel_at(UiInstance *instance, double x, double y);
+
+void render_panels(UiInstance *instance);
+void route_panel_mouse(UiInstance *instance, int32_t button, int32_t action);
+void dispose_panels(UiInstance *instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
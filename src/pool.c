@@ -0,0 +1,202 @@
+#include "pool.h"
+#include <stdlib.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#define POOL_THREADS
+#endif
+
+#ifdef POOL_THREADS
+// indices next..end-1 are still to be run by the owner or thieves
+typedef struct {
+  pthread_mutex_t lock;
+  uint32_t next, end;
+} PoolShare;
+
+static struct {
+  uint32_t threads;
+  pthread_t *workers;
+  PoolShare *shares;
+  pthread_mutex_t lock;
+  pthread_cond_t wake, done;
+  pthread_mutex_t run_lock;
+  uint64_t generation;
+  uint32_t busy;
+  uint8_t quit;
+  pool_task_t *task;
+  void *context;
+} g_pool = {.lock = PTHREAD_MUTEX_INITIALIZER,
+            .wake = PTHREAD_COND_INITIALIZER,
+            .done = PTHREAD_COND_INITIALIZER,
+            .run_lock = PTHREAD_MUTEX_INITIALIZER};
+
+static uint8_t take(PoolShare *share, uint32_t *index) {
+  pthread_mutex_lock(&share->lock);
+  uint8_t found = share->next < share->end;
+  if (found)
+    *index = share->next++;
+  pthread_mutex_unlock(&share->lock);
+  return found;
+}
+
+// moves the upper half of a victim's indices into the thief's empty share
+static uint8_t steal(uint32_t thief, uint32_t *index) {
+  for (uint32_t k = 1; k < g_pool.threads; k++) {
+    PoolShare *victim = &g_pool.shares[(thief + k) % g_pool.threads];
+    pthread_mutex_lock(&victim->lock);
+    uint32_t left = victim->end - victim->next;
+    if (left == 0) {
+      pthread_mutex_unlock(&victim->lock);
+      continue;
+    }
+    uint32_t start = victim->end - (left + 1) / 2, end = victim->end;
+    victim->end = start;
+    pthread_mutex_unlock(&victim->lock);
+    PoolShare *own = &g_pool.shares[thief];
+    pthread_mutex_lock(&own->lock);
+    own->next = start + 1;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    *index = start;
+    return 1;
+  }
+  return 0;
+}
+
+static void work(uint32_t thread) {
+  uint32_t index;
+  while (take(&g_pool.shares[thread], &index) || steal(thread, &index))
+    g_pool.task(g_pool.context, index);
+}
+
+static void *worker_main(void *arg) {
+  const uint32_t thread = (uint32_t)(uintptr_t)arg;
+  uint64_t seen = 0;
+  pthread_mutex_lock(&g_pool.lock);
+  for (;;) {
+    while (!g_pool.quit && g_pool.generation == seen)
+      pthread_cond_wait(&g_pool.wake, &g_pool.lock);
+    if (g_pool.quit)
+      break;
+    seen = g_pool.generation;
+    pthread_mutex_unlock(&g_pool.lock);
+    work(thread);
+    pthread_mutex_lock(&g_pool.lock);
+    if (--g_pool.busy == 0)
+      pthread_cond_signal(&g_pool.done);
+  }
+  pthread_mutex_unlock(&g_pool.lock);
+  return NULL;
+}
+
+static void stop_workers() {
+  pthread_mutex_lock(&g_pool.lock);
+  g_pool.quit = 1;
+  pthread_cond_broadcast(&g_pool.wake);
+  pthread_mutex_unlock(&g_pool.lock);
+  for (uint32_t i = 1; i < g_pool.threads; i++)
+    pthread_join(g_pool.workers[i], NULL);
+  for (uint32_t i = 0; i < g_pool.threads; i++)
+    pthread_mutex_destroy(&g_pool.shares[i].lock);
+  free(g_pool.workers);
+  free(g_pool.shares);
+  g_pool.workers = NULL;
+  g_pool.shares = NULL;
+  g_pool.threads = 0;
+  g_pool.quit = 0;
+}
+
+static uint32_t core_count() {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (uint32_t)cores : 1;
+}
+
+// slot 0 of workers and shares belongs to the thread calling pool_run
+static uint8_t start_workers(uint32_t count) {
+  g_pool.workers = calloc(count, sizeof(pthread_t));
+  g_pool.shares = calloc(count, sizeof(PoolShare));
+  if (!g_pool.workers || !g_pool.shares) {
+    free(g_pool.workers);
+    free(g_pool.shares);
+    g_pool.workers = NULL;
+    g_pool.shares = NULL;
+    return 1;
+  }
+  for (uint32_t i = 0; i < count; i++)
+    pthread_mutex_init(&g_pool.shares[i].lock, NULL);
+  g_pool.threads = 1;
+  g_pool.generation = 0;
+  for (uint32_t i = 1; i < count; i++) {
+    if (pthread_create(&g_pool.workers[i], NULL, worker_main,
+                       (void *)(uintptr_t)i) != 0)
+      break;
+    g_pool.threads++;
+  }
+  return 0;
+}
+
+uint8_t set_thread_count(uint32_t count) {
+  pthread_mutex_lock(&g_pool.run_lock);
+  if (count == 0)
+    count = core_count();
+  if (g_pool.threads)
+    stop_workers();
+  uint8_t failed = start_workers(count);
+  pthread_mutex_unlock(&g_pool.run_lock);
+  return failed;
+}
+
+static void ensure_workers() {
+  pthread_mutex_lock(&g_pool.run_lock);
+  if (!g_pool.threads)
+    start_workers(core_count());
+  pthread_mutex_unlock(&g_pool.run_lock);
+}
+
+uint32_t get_thread_count() {
+  if (!g_pool.threads)
+    ensure_workers();
+  return g_pool.threads ? g_pool.threads : 1;
+}
+
+void pool_run(pool_task_t *task, void *context, uint32_t count) {
+  if (count == 0)
+    return;
+  if (!g_pool.threads)
+    ensure_workers();
+  if (g_pool.threads < 2 || count < 2 ||
+      pthread_mutex_trylock(&g_pool.run_lock) != 0) {
+    for (uint32_t i = 0; i < count; i++)
+      task(context, i);
+    return;
+  }
+  const uint32_t threads = g_pool.threads;
+  for (uint32_t i = 0; i < threads; i++) {
+    g_pool.shares[i].next = (uint32_t)((uint64_t)count * i / threads);
+    g_pool.shares[i].end = (uint32_t)((uint64_t)count * (i + 1) / threads);
+  }
+  pthread_mutex_lock(&g_pool.lock);
+  g_pool.task = task;
+  g_pool.context = context;
+  g_pool.busy = threads - 1;
+  g_pool.generation++;
+  pthread_cond_broadcast(&g_pool.wake);
+  pthread_mutex_unlock(&g_pool.lock);
+  work(0);
+  pthread_mutex_lock(&g_pool.lock);
+  while (g_pool.busy > 0)
+    pthread_cond_wait(&g_pool.done, &g_pool.lock);
+  pthread_mutex_unlock(&g_pool.lock);
+  pthread_mutex_unlock(&g_pool.run_lock);
+}
+#else
+// no worker threads on this platform, everything runs on the caller
+void pool_run(pool_task_t *task, void *context, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++)
+    task(context, i);
+}
+
+uint8_t set_thread_count(uint32_t count) { return count > 1; }
+
+uint32_t get_thread_count() { return 1; }
+#endif
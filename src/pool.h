@@ -0,0 +1,27 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void pool_task_t(void *context, uint32_t index);
+
+/*
+ * Runs task(context, i) for every i below count on the worker threads and
+ * the calling thread, returns once all of them finished. Every thread starts
+ * on its own contiguous share of the indices and steals half of the rest of
+ * another share when it runs out. Nested or concurrent calls run serially.
+ */
+void pool_run(pool_task_t *task, void *context, uint32_t count);
+
+// threads used by pool_run including the caller, 0 picks the core count
+uint8_t set_thread_count(uint32_t count);
+uint32_t get_thread_count();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,274 @@
+#include "program.h"
+#include "startup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#define make_dir(path) mkdir(path, 0755)
+#endif
+
+// GL_ARB_get_program_binary, core in 4.1 which glad is not generated for
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void(APIENTRYP get_program_binary_t)(GLuint program, GLsizei size,
+                                             GLsizei *length, GLenum *format,
+                                             void *binary);
+typedef void(APIENTRYP program_binary_t)(GLuint program, GLenum format,
+                                         const void *binary, GLsizei length);
+typedef void(APIENTRYP program_parameteri_t)(GLuint program, GLenum name,
+                                             GLint value);
+
+static const char program_cache_magic[4] = {'B', 'U', 'P', 'B'};
+
+static GLFWwindow *g_share_window = NULL;
+static SharedProgram *g_programs = NULL;
+static uint32_t g_program_count = 0;
+// NULL picks the default below, an empty string disables the cache
+static char *g_cache_dir = NULL;
+static int8_t g_binary_support = -1;
+static get_program_binary_t get_program_binary = NULL;
+static program_binary_t program_binary = NULL;
+static program_parameteri_t program_parameteri = NULL;
+
+/*
+ * Hidden window every other window shares its objects with. It is never
+ * destroyed, so shared programs and textures outlive the windows using them.
+ */
+GLFWwindow *share_window() {
+  if (g_share_window)
+    return g_share_window;
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  g_share_window = glfwCreateWindow(1, 1, "", NULL, NULL);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+  return g_share_window;
+}
+
+static char *copy_string(const char *value) {
+  size_t length = strlen(value) + 1;
+  char *copy = malloc(length);
+  if (copy)
+    memcpy(copy, value, length);
+  return copy;
+}
+
+uint8_t set_program_cache_dir(const char *path) {
+  // a threaded prewarm may be reading it
+  prewarm_wait();
+  free(g_cache_dir);
+  g_cache_dir = NULL;
+  if (!path)
+    return 0;
+  g_cache_dir = copy_string(path);
+  return g_cache_dir ? 0 : 1;
+}
+
+static const char *program_cache_dir() {
+  if (g_cache_dir)
+    return g_cache_dir;
+  static char fallback[1024];
+  const char *base = getenv("XDG_CACHE_HOME");
+  const char *suffix = "bun-ui";
+  if (!base || !*base) {
+#ifdef _WIN32
+    base = getenv("LOCALAPPDATA");
+#else
+    base = getenv("HOME");
+    suffix = ".cache/bun-ui";
+#endif
+  }
+  if (!base || !*base)
+    return "";
+  snprintf(fallback, sizeof(fallback), "%s/%s", base, suffix);
+  return fallback;
+}
+
+// creates every missing directory along the path
+static void make_dirs(const char *path) {
+  char buffer[1024];
+  size_t length = strlen(path);
+  if (length >= sizeof(buffer))
+    return;
+  memcpy(buffer, path, length + 1);
+  for (size_t i = 1; i <= length; i++) {
+    if (buffer[i] != '/' && buffer[i] != '\\' && buffer[i] != '\0')
+      continue;
+    char c = buffer[i];
+    buffer[i] = '\0';
+    make_dir(buffer);
+    buffer[i] = c;
+  }
+}
+
+static uint8_t binary_supported() {
+  if (g_binary_support >= 0)
+    return g_binary_support;
+  g_binary_support = 0;
+  if (!glfwExtensionSupported("GL_ARB_get_program_binary"))
+    return 0;
+  get_program_binary =
+      (get_program_binary_t)glfwGetProcAddress("glGetProgramBinary");
+  program_binary = (program_binary_t)glfwGetProcAddress("glProgramBinary");
+  program_parameteri =
+      (program_parameteri_t)glfwGetProcAddress("glProgramParameteri");
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  g_binary_support =
+      get_program_binary && program_binary && program_parameteri && formats > 0;
+  return g_binary_support;
+}
+
+static uint64_t fnv1a(uint64_t hash, const char *data) {
+  // the terminator is hashed too so "ab" + "c" differs from "a" + "bc"
+  do {
+    hash ^= (uint8_t)*data;
+    hash *= 0x100000001b3ULL;
+  } while (*data++);
+  return hash;
+}
+
+/*
+ * Binaries are only valid for the driver that produced them, so the key
+ * covers the driver strings next to the sources.
+ */
+static uint8_t program_cache_path(char *out, size_t size,
+                                  const char *vertex_content,
+                                  const char *fragment_content) {
+  const char *dir = program_cache_dir();
+  if (!*dir)
+    return 1;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash = fnv1a(hash, vertex_content);
+  hash = fnv1a(hash, fragment_content);
+  const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+  for (size_t i = 0; i < 3; i++) {
+    const char *value = (const char *)glGetString(strings[i]);
+    hash = fnv1a(hash, value ? value : "");
+  }
+  int written = snprintf(out, size, "%s/%016llx.bin", dir,
+                         (unsigned long long)hash);
+  return written < 0 || (size_t)written >= size;
+}
+
+static uint8_t load_program_binary(GLuint pid, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return 1;
+  char magic[4];
+  uint32_t format = 0;
+  uint8_t *binary = NULL;
+  uint8_t failed = 1;
+  long length = 0;
+  if (fread(magic, 1, 4, file) != 4 ||
+      memcmp(magic, program_cache_magic, 4) != 0 ||
+      fread(&format, sizeof(format), 1, file) != 1)
+    goto done;
+  long start = ftell(file);
+  fseek(file, 0, SEEK_END);
+  length = ftell(file) - start;
+  fseek(file, start, SEEK_SET);
+  if (length <= 0 || !(binary = malloc(length)) ||
+      fread(binary, 1, length, file) != (size_t)length)
+    goto done;
+  program_binary(pid, format, binary, (GLsizei)length);
+  // the driver rejects binaries from other versions through the link status
+  GLint linked = 0;
+  glGetProgramiv(pid, GL_LINK_STATUS, &linked);
+  failed = !linked;
+done:
+  free(binary);
+  fclose(file);
+  return failed;
+}
+
+static void store_program_binary(GLuint pid, const char *path) {
+  GLint length = 0;
+  glGetProgramiv(pid, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  uint8_t *binary = malloc(length);
+  if (!binary)
+    return;
+  GLenum format = 0;
+  get_program_binary(pid, length, &length, &format, binary);
+  make_dirs(program_cache_dir());
+  // written under a temporary name so other processes never read half a file
+  char temp_path[1100];
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+  FILE *file = fopen(temp_path, "wb");
+  if (file) {
+    uint32_t stored_format = format;
+    uint8_t ok = fwrite(program_cache_magic, 1, 4, file) == 4 &&
+                 fwrite(&stored_format, sizeof(stored_format), 1, file) == 1 &&
+                 fwrite(binary, 1, length, file) == (size_t)length;
+    ok = fclose(file) == 0 && ok;
+    remove(path);
+    if (!ok || rename(temp_path, path) != 0)
+      remove(temp_path);
+  }
+  free(binary);
+}
+
+static void link_program(SharedProgram *program) {
+  program->vertex_shader_id =
+      simple_compile_shader(GL_VERTEX_SHADER, program->vertex_content);
+  program->fragment_shader_id =
+      simple_compile_shader(GL_FRAGMENT_SHADER, program->fragment_content);
+  glAttachShader(program->pid, program->vertex_shader_id);
+  glAttachShader(program->pid, program->fragment_shader_id);
+  glLinkProgram(program->pid);
+}
+
+SharedProgram *shared_program(const char *vertex_content,
+                              const char *fragment_content) {
+  for (uint32_t i = 0; i < g_program_count; i++) {
+    SharedProgram *program = &g_programs[i];
+    if (strcmp(program->vertex_content, vertex_content) == 0 &&
+        strcmp(program->fragment_content, fragment_content) == 0)
+      return program;
+  }
+  // the entry outlives the caller's sources, which need not be literals
+  char *vertex_copy = copy_string(vertex_content);
+  char *fragment_copy = copy_string(fragment_content);
+  SharedProgram *resized =
+      vertex_copy && fragment_copy
+          ? realloc(g_programs, sizeof(SharedProgram) * (g_program_count + 1))
+          : NULL;
+  if (!resized) {
+    free(vertex_copy);
+    free(fragment_copy);
+    return NULL;
+  }
+  g_programs = resized;
+  SharedProgram *program = &g_programs[g_program_count++];
+  memset(program, 0, sizeof(SharedProgram));
+  program->vertex_content = vertex_copy;
+  program->fragment_content = fragment_copy;
+  program->pid = glCreateProgram();
+
+  char path[1024];
+  uint8_t cached = binary_supported() &&
+                   !program_cache_path(path, sizeof(path), vertex_content,
+                                       fragment_content);
+  if (cached && !load_program_binary(program->pid, path)) {
+    program->from_cache = 1;
+    return program;
+  }
+  if (cached) {
+    // a failed glProgramBinary leaves the program unusable, start over
+    glDeleteProgram(program->pid);
+    program->pid = glCreateProgram();
+    program_parameteri(program->pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                       GL_TRUE);
+  }
+  link_program(program);
+  GLint linked = 0;
+  glGetProgramiv(program->pid, GL_LINK_STATUS, &linked);
+  if (cached && linked)
+    store_program_binary(program->pid, path);
+  return program;
+}
@@ -0,0 +1,39 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Linked program shared by every window of the context group. Shaders keep
+ * their own vao and vbo, only the program is looked up here by its sources.
+ * Programs stay linked for the lifetime of the share window, so reopening
+ * windows does not compile anything again. The sources are copied.
+ */
+typedef struct {
+  const char *vertex_content;
+  const char *fragment_content;
+  GLuint pid, vertex_shader_id, fragment_shader_id;
+  // loaded from the program binary cache, there are no shader objects
+  uint8_t from_cache;
+} SharedProgram;
+
+GLFWwindow *share_window();
+
+/*
+ * Linked programs are also kept on disk as driver binaries, keyed by the
+ * sources and the GL vendor, renderer and version. NULL restores the default
+ * ($XDG_CACHE_HOME/bun-ui or ~/.cache/bun-ui), an empty path disables it.
+ */
+uint8_t set_program_cache_dir(const char *path);
+
+SharedProgram *shared_program(const char *vertex_content,
+                              const char *fragment_content);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,580 @@
+#include "raster.h"
+#include "pool.h"
+#include "text.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a drawing command, or one segment of a polyline, with the state it uses
+typedef struct {
+  uint32_t at;
+  int32_t segment;
+  RgbaColor color;
+  float line_width;
+  int32_t clip_x0, clip_y0, clip_x1, clip_y1;
+} Primitive;
+
+typedef struct {
+  Image *image;
+  uint8_t pixel_size;
+  RgbaColor color;
+  float line_width;
+  // added to every coordinate
+  float offset_x, offset_y;
+  // inclusive start, exclusive end, always inside the image
+  int32_t clip_x0, clip_y0, clip_x1, clip_y1;
+  // CLIP commands can only narrow this one
+  int32_t base_x0, base_y0, base_x1, base_y1;
+  // collect the covered area into bounds instead of drawing
+  uint8_t measure;
+  float bounds[4];
+  // set while binning, every measured primitive is appended here
+  Primitive *primitives;
+  uint32_t primitive_count, primitive_capacity;
+  uint8_t binning, bin_failed;
+} Raster;
+
+static void reset_clip(Raster *raster) {
+  raster->clip_x0 = raster->base_x0;
+  raster->clip_y0 = raster->base_y0;
+  raster->clip_x1 = raster->base_x1;
+  raster->clip_y1 = raster->base_y1;
+}
+
+static void touch(Raster *raster, float x0, float y0, float x1, float y1) {
+  if (x0 < raster->bounds[0])
+    raster->bounds[0] = x0;
+  if (y0 < raster->bounds[1])
+    raster->bounds[1] = y0;
+  if (x1 > raster->bounds[2])
+    raster->bounds[2] = x1;
+  if (y1 > raster->bounds[3])
+    raster->bounds[3] = y1;
+}
+
+// source over with the colour alpha scaled by the coverage
+static void blend(Raster *raster, int32_t x, int32_t y, float coverage) {
+  if (x < raster->clip_x0 || y < raster->clip_y0 || x >= raster->clip_x1 ||
+      y >= raster->clip_y1 || coverage <= 0)
+    return;
+  RgbaColor c = raster->color;
+  uint8_t *px = raster->image->buffer +
+                ((size_t)y * raster->image->w + x) * raster->pixel_size;
+  uint8_t r = c.r, b = c.b;
+  if (raster->image->type == BGRA) {
+    r = c.b;
+    b = c.r;
+  }
+  float a = (coverage > 1 ? 1 : coverage) * c.a / 255.0f;
+  px[0] = (uint8_t)(px[0] + (r - px[0]) * a + 0.5f);
+  px[1] = (uint8_t)(px[1] + (c.g - px[1]) * a + 0.5f);
+  px[2] = (uint8_t)(px[2] + (b - px[2]) * a + 0.5f);
+  if (raster->pixel_size == 4)
+    px[3] = (uint8_t)(px[3] + (255 - px[3]) * a + 0.5f);
+}
+
+static void clamp_span(Raster *raster, float lo_x, float lo_y, float hi_x,
+                       float hi_y, int32_t *x0, int32_t *y0, int32_t *x1,
+                       int32_t *y1) {
+  *x0 = lo_x > raster->clip_x0 ? (int32_t)floorf(lo_x) : raster->clip_x0;
+  *y0 = lo_y > raster->clip_y0 ? (int32_t)floorf(lo_y) : raster->clip_y0;
+  *x1 = hi_x < raster->clip_x1 ? (int32_t)ceilf(hi_x) : raster->clip_x1;
+  *y1 = hi_y < raster->clip_y1 ? (int32_t)ceilf(hi_y) : raster->clip_y1;
+}
+
+static float overlap(float a0, float a1, float b0, float b1) {
+  float lo = a0 > b0 ? a0 : b0, hi = a1 < b1 ? a1 : b1;
+  return hi > lo ? hi - lo : 0;
+}
+
+// edge pixels are covered by the fraction of the pixel inside the rect
+static void fill_rect(Raster *raster, float x, float y, float w, float h) {
+  if (w < 0) {
+    x += w;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h;
+    h = -h;
+  }
+  if (raster->measure) {
+    touch(raster, x, y, x + w, y + h);
+    return;
+  }
+  int32_t x0, y0, x1, y1;
+  clamp_span(raster, x, y, x + w, y + h, &x0, &y0, &x1, &y1);
+  for (int32_t py = y0; py < y1; py++) {
+    float cover_y = overlap(py, py + 1, y, y + h);
+    for (int32_t px = x0; px < x1; px++)
+      blend(raster, px, py, cover_y * overlap(px, px + 1, x, x + w));
+  }
+}
+
+static void stroke_line(Raster *raster, float x0, float y0, float x1,
+                        float y1) {
+  const float half = raster->line_width / 2;
+  const float dx = x1 - x0, dy = y1 - y0;
+  const float len_sq = dx * dx + dy * dy;
+  const float lo_x = (x0 < x1 ? x0 : x1) - half - 1;
+  const float lo_y = (y0 < y1 ? y0 : y1) - half - 1;
+  const float hi_x = (x0 > x1 ? x0 : x1) + half + 1;
+  const float hi_y = (y0 > y1 ? y0 : y1) + half + 1;
+  if (raster->measure) {
+    touch(raster, lo_x, lo_y, hi_x, hi_y);
+    return;
+  }
+  int32_t bx0, by0, bx1, by1;
+  clamp_span(raster, lo_x, lo_y, hi_x, hi_y, &bx0, &by0, &bx1, &by1);
+  // reach of the stroke measured across the infinite line
+  const float across = (half + 1) * sqrtf(len_sq);
+  for (int32_t py = by0; py < by1; py++) {
+    int32_t row_x0 = bx0, row_x1 = bx1;
+    if (fabsf(dy) > 1e-6f) {
+      // only the part of the row inside the band around the line
+      float along = (py + 0.5f - y0) * dx;
+      float a = x0 + (along - across) / dy, b = x0 + (along + across) / dy;
+      float lo = (a < b ? a : b) - 1, hi = (a > b ? a : b) + 1;
+      if (lo > row_x0)
+        row_x0 = (int32_t)floorf(lo);
+      if (hi < row_x1)
+        row_x1 = (int32_t)ceilf(hi);
+    }
+    for (int32_t px = row_x0; px < row_x1; px++) {
+      float cx = px + 0.5f - x0, cy = py + 0.5f - y0;
+      float t = len_sq > 0 ? (cx * dx + cy * dy) / len_sq : 0;
+      t = t < 0 ? 0 : t > 1 ? 1 : t;
+      float ex = cx - t * dx, ey = cy - t * dy;
+      float distance = sqrtf(ex * ex + ey * ey);
+      blend(raster, px, py, half + 0.5f - distance);
+    }
+  }
+}
+
+static uint8_t angle_inside(float angle, float start, float end) {
+  const float tau = 6.28318530718f;
+  if (end - start >= tau)
+    return 1;
+  float offset = fmodf(angle - start, tau);
+  if (offset < 0)
+    offset += tau;
+  return offset <= end - start;
+}
+
+// filled arcs are pie sectors, stroked ones follow the circle
+static void draw_arc(Raster *raster, float cx, float cy, float radius,
+                     float start, float end, uint8_t fill) {
+  if (end < start) {
+    float swap = start;
+    start = end;
+    end = swap;
+  }
+  const float half = fill ? 0 : raster->line_width / 2;
+  const float reach = radius + half + 1;
+  if (raster->measure) {
+    touch(raster, cx - reach, cy - reach, cx + reach, cy + reach);
+    return;
+  }
+  int32_t x0, y0, x1, y1;
+  clamp_span(raster, cx - reach, cy - reach, cx + reach, cy + reach, &x0, &y0,
+             &x1, &y1);
+  for (int32_t py = y0; py < y1; py++) {
+    for (int32_t px = x0; px < x1; px++) {
+      float dx = px + 0.5f - cx, dy = py + 0.5f - cy;
+      float distance = sqrtf(dx * dx + dy * dy);
+      float coverage = fill ? radius + 0.5f - distance
+                            : half + 0.5f - fabsf(distance - radius);
+      // the angle is only worth computing for covered pixels
+      if (coverage > 0 && angle_inside(atan2f(dy, dx), start, end))
+        blend(raster, px, py, coverage);
+    }
+  }
+}
+
+static void draw_text(Raster *raster, float x, float y, uint32_t font,
+                      uint8_t align, uint8_t baseline,
+                      const uint32_t *codepoints, uint32_t count) {
+  atlas_lock_shared();
+  const uint8_t *atlas = atlas_pixels();
+  if (!atlas || !text_font_exists(font)) {
+    atlas_unlock_shared();
+    return;
+  }
+  const uint32_t size = atlas_size();
+  float base;
+  float pen = text_origin(font, codepoints, count, align, baseline, &base);
+  int32_t origin_x = (int32_t)floorf(x + 0.5f);
+  int32_t origin_y = (int32_t)floorf(y + 0.5f);
+  for (uint32_t i = 0; i < count; i++) {
+    Glyph *glyph = text_glyph(font, codepoints[i]);
+    if (!glyph)
+      continue;
+    int32_t gx = origin_x + (int32_t)floorf(pen + glyph->bearing_x + 0.5f);
+    int32_t gy = origin_y + (int32_t)floorf(base - glyph->bearing_y + 0.5f);
+    pen += glyph->advance;
+    if (raster->measure) {
+      touch(raster, gx, gy, gx + glyph->w, gy + glyph->h);
+      continue;
+    }
+    for (uint32_t row = 0; row < glyph->h; row++) {
+      const uint8_t *src = atlas + (size_t)(glyph->y + row) * size + glyph->x;
+      for (uint32_t col = 0; col < glyph->w; col++)
+        blend(raster, gx + col, gy + row, src[col] / 255.0f);
+    }
+  }
+  atlas_unlock_shared();
+}
+
+static float read_f32(const uint32_t *word) {
+  float value;
+  memcpy(&value, word, sizeof(float));
+  return value;
+}
+
+static void begin_primitive(Raster *raster) {
+  raster->bounds[0] = raster->bounds[1] = INFINITY;
+  raster->bounds[2] = raster->bounds[3] = -INFINITY;
+}
+
+// keeps the primitive if it touches pixels inside the current clip
+static void end_primitive(Raster *raster, uint32_t at, int32_t segment) {
+  int32_t x0, y0, x1, y1;
+  if (raster->bounds[0] > raster->bounds[2])
+    return;
+  clamp_span(raster, raster->bounds[0], raster->bounds[1], raster->bounds[2],
+             raster->bounds[3], &x0, &y0, &x1, &y1);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  if (raster->primitive_count == raster->primitive_capacity) {
+    uint32_t capacity =
+        raster->primitive_capacity ? raster->primitive_capacity * 2 : 256;
+    Primitive *resized =
+        realloc(raster->primitives, sizeof(Primitive) * capacity);
+    if (!resized) {
+      raster->bin_failed = 1;
+      return;
+    }
+    raster->primitives = resized;
+    raster->primitive_capacity = capacity;
+  }
+  Primitive primitive = {at, segment, raster->color, raster->line_width,
+                         x0, y0, x1, y1};
+  raster->primitives[raster->primitive_count++] = primitive;
+}
+
+/*
+ * Decodes the command at words[at], the words are read in native byte order
+ * which is little endian on every supported target. A segment of zero or
+ * more only draws that segment of a polyline. Returns the index after the
+ * command or 0 when it is truncated or unknown.
+ */
+static uint32_t run_command(Raster *raster, const uint32_t *words,
+                            uint32_t count, uint32_t at, int32_t segment) {
+  const float ox = raster->offset_x, oy = raster->offset_y;
+  uint32_t i = at;
+  uint32_t op = words[i++];
+#define NEED(n)                                                                \
+  if (i + (n) > count)                                                         \
+    return 0;
+#define X(n) (read_f32(&words[i + (n)]) + ox)
+#define Y(n) (read_f32(&words[i + (n)]) + oy)
+  if (op == CMD_COLOR) {
+    NEED(1);
+    const uint8_t *rgba = (const uint8_t *)&words[i++];
+    RgbaColor color = {rgba[0], rgba[1], rgba[2], rgba[3]};
+    raster->color = color;
+  } else if (op == CMD_CLEAR) {
+    if (raster->measure)
+      touch(raster, raster->clip_x0, raster->clip_y0, raster->clip_x1,
+            raster->clip_y1);
+    else
+      fill_rect(raster, raster->clip_x0, raster->clip_y0,
+                raster->clip_x1 - raster->clip_x0,
+                raster->clip_y1 - raster->clip_y0);
+  } else if (op == CMD_LINE_WIDTH) {
+    NEED(1);
+    raster->line_width = read_f32(&words[i++]);
+  } else if (op == CMD_CLIP) {
+    NEED(4);
+    float x = X(0), y = Y(1);
+    float w = read_f32(&words[i + 2]), h = read_f32(&words[i + 3]);
+    i += 4;
+    reset_clip(raster);
+    if (w > 0 && h > 0)
+      clamp_span(raster, x, y, x + w, y + h, &raster->clip_x0,
+                 &raster->clip_y0, &raster->clip_x1, &raster->clip_y1);
+  } else if (op == CMD_RECT) {
+    NEED(4);
+    fill_rect(raster, X(0), Y(1), read_f32(&words[i + 2]),
+              read_f32(&words[i + 3]));
+    i += 4;
+  } else if (op == CMD_LINE) {
+    NEED(4);
+    stroke_line(raster, X(0), Y(1), X(2), Y(3));
+    i += 4;
+  } else if (op == CMD_POLYLINE) {
+    NEED(1);
+    uint32_t points = words[i++];
+    NEED((uint64_t)points * 2);
+    for (uint32_t p = 1; p < points; p++) {
+      if (segment >= 0 && p != (uint32_t)segment)
+        continue;
+      if (raster->binning)
+        begin_primitive(raster);
+      stroke_line(raster, X(p * 2 - 2), Y(p * 2 - 1), X(p * 2),
+                  Y(p * 2 + 1));
+      if (raster->binning)
+        end_primitive(raster, at, p);
+    }
+    i += points * 2;
+  } else if (op == CMD_ARC) {
+    NEED(6);
+    draw_arc(raster, X(0), Y(1), read_f32(&words[i + 2]),
+             read_f32(&words[i + 3]), read_f32(&words[i + 4]),
+             words[i + 5] != 0);
+    i += 6;
+  } else if (op == CMD_TEXT) {
+    NEED(6);
+    float x = X(0), y = Y(1);
+    uint32_t font = words[i + 2], align = words[i + 3];
+    uint32_t baseline = words[i + 4], chars = words[i + 5];
+    i += 6;
+    NEED((uint64_t)chars);
+    draw_text(raster, x, y, font, align, baseline, &words[i], chars);
+    i += chars;
+  } else {
+    return 0;
+  }
+#undef NEED
+#undef X
+#undef Y
+  return i;
+}
+
+static uint8_t run_commands(Raster *raster, const uint32_t *words,
+                            uint32_t count) {
+  uint32_t i = 0;
+  while (i < count) {
+    // polylines bin every segment on their own
+    uint8_t single = raster->binning && words[i] != CMD_POLYLINE;
+    if (single)
+      begin_primitive(raster);
+    uint32_t next = run_command(raster, words, count, i, -1);
+    if (!next)
+      return 1;
+    if (single)
+      end_primitive(raster, i, -1);
+    i = next;
+  }
+  return 0;
+}
+
+static void raster_init(Raster *raster, Image *image, float offset_x,
+                        float offset_y, const int32_t *clip) {
+  memset(raster, 0, sizeof(Raster));
+  RgbaColor black = {0, 0, 0, 255};
+  raster->image = image;
+  raster->pixel_size = get_buffer_pixel_size(image);
+  raster->color = black;
+  raster->line_width = 1;
+  raster->offset_x = offset_x;
+  raster->offset_y = offset_y;
+  raster->base_x1 = image->w;
+  raster->base_y1 = image->h;
+  if (clip) {
+    raster->base_x0 = clip[0] > 0 ? clip[0] : 0;
+    raster->base_y0 = clip[1] > 0 ? clip[1] : 0;
+    if (clip[2] < raster->base_x1)
+      raster->base_x1 = clip[2];
+    if (clip[3] < raster->base_y1)
+      raster->base_y1 = clip[3];
+  }
+  reset_clip(raster);
+}
+
+#define RASTER_TILE 64
+// below this many pixels binning costs more than the threads save
+#define RASTER_PARALLEL_PIXELS (256 * 256)
+
+typedef struct {
+  const Raster *base;
+  const uint32_t *words;
+  uint32_t count;
+  uint32_t cols;
+  // primitives of tile t are items[starts[t]] up to items[starts[t + 1]]
+  uint32_t *starts;
+  uint32_t *items;
+} TileJob;
+
+static void tile_range(const TileJob *job, const Primitive *p, uint32_t *c0,
+                       uint32_t *r0, uint32_t *c1, uint32_t *r1) {
+  const Raster *base = job->base;
+  *c0 = (p->clip_x0 - base->base_x0) / RASTER_TILE;
+  *r0 = (p->clip_y0 - base->base_y0) / RASTER_TILE;
+  *c1 = (p->clip_x1 - 1 - base->base_x0) / RASTER_TILE;
+  *r1 = (p->clip_y1 - 1 - base->base_y0) / RASTER_TILE;
+}
+
+// tiles never share pixels, so they are drawn without any locking
+static void raster_tile(void *context, uint32_t tile) {
+  const TileJob *job = context;
+  const Raster *base = job->base;
+  if (job->starts[tile] == job->starts[tile + 1])
+    return;
+  Raster raster = *base;
+  raster.binning = 0;
+  raster.base_x0 = base->base_x0 + (tile % job->cols) * RASTER_TILE;
+  raster.base_y0 = base->base_y0 + (tile / job->cols) * RASTER_TILE;
+  raster.base_x1 = raster.base_x0 + RASTER_TILE;
+  raster.base_y1 = raster.base_y0 + RASTER_TILE;
+  if (raster.base_x1 > base->base_x1)
+    raster.base_x1 = base->base_x1;
+  if (raster.base_y1 > base->base_y1)
+    raster.base_y1 = base->base_y1;
+  for (uint32_t i = job->starts[tile]; i < job->starts[tile + 1]; i++) {
+    const Primitive *p = &base->primitives[job->items[i]];
+    raster.color = p->color;
+    raster.line_width = p->line_width;
+    raster.clip_x0 = p->clip_x0 > raster.base_x0 ? p->clip_x0 : raster.base_x0;
+    raster.clip_y0 = p->clip_y0 > raster.base_y0 ? p->clip_y0 : raster.base_y0;
+    raster.clip_x1 = p->clip_x1 < raster.base_x1 ? p->clip_x1 : raster.base_x1;
+    raster.clip_y1 = p->clip_y1 < raster.base_y1 ? p->clip_y1 : raster.base_y1;
+    run_command(&raster, job->words, job->count, p->at, p->segment);
+  }
+}
+
+/*
+ * Measures every primitive once, bins it into the 64x64 tiles its clipped
+ * bounds touch and draws the tiles on the thread pool. Each tile replays
+ * its primitives in command order, so the result matches a serial run.
+ */
+static uint8_t raster_parallel(Raster *raster, const uint32_t *words,
+                               uint32_t count) {
+  raster->measure = 1;
+  raster->binning = 1;
+  uint8_t failed = run_commands(raster, words, count);
+  raster->measure = 0;
+  raster->binning = 0;
+  const uint32_t cols =
+      (raster->base_x1 - raster->base_x0 + RASTER_TILE - 1) / RASTER_TILE;
+  const uint32_t rows =
+      (raster->base_y1 - raster->base_y0 + RASTER_TILE - 1) / RASTER_TILE;
+  TileJob job = {raster, words, count, cols, NULL, NULL};
+  job.starts = calloc((size_t)cols * rows + 1, sizeof(uint32_t));
+  uint64_t total = 0;
+  for (uint32_t i = 0; job.starts && i < raster->primitive_count; i++) {
+    uint32_t c0, r0, c1, r1;
+    tile_range(&job, &raster->primitives[i], &c0, &r0, &c1, &r1);
+    total += (uint64_t)(c1 - c0 + 1) * (r1 - r0 + 1);
+    for (uint32_t r = r0; r <= r1; r++) {
+      for (uint32_t c = c0; c <= c1; c++)
+        job.starts[r * cols + c + 1]++;
+    }
+  }
+  if (job.starts && total <= UINT32_MAX)
+    job.items = malloc(sizeof(uint32_t) * (total ? total : 1));
+  if (!job.items || raster->bin_failed) {
+    free(job.starts);
+    free(job.items);
+    free(raster->primitives);
+    return 1;
+  }
+  for (uint32_t t = 0; t < cols * rows; t++)
+    job.starts[t + 1] += job.starts[t];
+  // second pass fills the tiles, fill[t] is the next free item of tile t
+  uint32_t *fill = malloc(sizeof(uint32_t) * cols * rows);
+  if (fill) {
+    memcpy(fill, job.starts, sizeof(uint32_t) * cols * rows);
+    for (uint32_t i = 0; i < raster->primitive_count; i++) {
+      uint32_t c0, r0, c1, r1;
+      tile_range(&job, &raster->primitives[i], &c0, &r0, &c1, &r1);
+      for (uint32_t r = r0; r <= r1; r++) {
+        for (uint32_t c = c0; c <= c1; c++)
+          job.items[fill[r * cols + c]++] = i;
+      }
+    }
+    pool_run(raster_tile, &job, cols * rows);
+  }
+  free(fill);
+  free(job.starts);
+  free(job.items);
+  free(raster->primitives);
+  return failed || !fill;
+}
+
+uint8_t raster_commands(Image *image, const uint32_t *words, uint32_t count,
+                        float offset_x, float offset_y, const int32_t *clip) {
+  if (!image->buffer || !image_is_color(image))
+    return 1;
+  Raster raster;
+  raster_init(&raster, image, offset_x, offset_y, clip);
+  const uint64_t pixels = (uint64_t)(raster.base_x1 - raster.base_x0) *
+                          (raster.base_y1 - raster.base_y0);
+  if (raster.base_x1 > raster.base_x0 && raster.base_y1 > raster.base_y0 &&
+      pixels >= RASTER_PARALLEL_PIXELS && get_thread_count() > 1)
+    return raster_parallel(&raster, words, count);
+  return run_commands(&raster, words, count);
+}
+
+uint8_t command_bounds(Image *image, const uint32_t *words, uint32_t count,
+                       float *bounds) {
+  Raster raster;
+  raster_init(&raster, image, 0, 0, NULL);
+  raster.measure = 1;
+  raster.bounds[0] = raster.bounds[1] = INFINITY;
+  raster.bounds[2] = raster.bounds[3] = -INFINITY;
+  uint8_t failed = run_commands(&raster, words, count);
+  memcpy(bounds, raster.bounds, sizeof(raster.bounds));
+  return failed;
+}
+
+uint32_t *copy_command_words(const uint8_t *commands, uint32_t length) {
+  uint32_t *copy = malloc((size_t)(length / 4) * 4 + 4);
+  if (copy)
+    memcpy(copy, commands, (size_t)(length / 4) * 4);
+  return copy;
+}
+
+uint8_t execute_commands(UiInstance *instance, const uint8_t *commands,
+                         uint32_t length) {
+  Image *image = &instance->render_buffer;
+  if (!image->buffer || !image_is_color(image))
+    return 1;
+  const uint32_t *words = (const uint32_t *)commands;
+  uint32_t *copy = NULL;
+  // views into an ArrayBuffer can start at any byte offset
+  if ((uintptr_t)commands % 4) {
+    if (!(copy = copy_command_words(commands, length)))
+      return 1;
+    words = copy;
+  }
+  uint8_t failed = raster_commands(image, words, length / 4, 0, 0, NULL);
+  free(copy);
+  image->dirty = 1;
+  instance->needs_render = 1;
+  return failed;
+}
+
+uint8_t rasterize_commands(uint8_t *pixels, uint32_t w, uint32_t h,
+                           const char *type, const uint8_t *commands,
+                           uint32_t length) {
+  Image image = {0};
+  // unknown type names keep the scalar placeholder and are rejected
+  image.type = R32F;
+  image_set_type(&image, type);
+  if (!image_is_color(&image))
+    return 1;
+  image.w = w;
+  image.h = h;
+  image.buffer = pixels;
+  image.buffer_size = (size_t)w * h * get_buffer_pixel_size(&image);
+  const uint32_t *words = (const uint32_t *)commands;
+  uint32_t *copy = NULL;
+  if ((uintptr_t)commands % 4) {
+    if (!(copy = copy_command_words(commands, length)))
+      return 1;
+    words = copy;
+  }
+  uint8_t failed = raster_commands(&image, words, length / 4, 0, 0, NULL);
+  free(copy);
+  return failed;
+}
@@ -0,0 +1,58 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Command buffer opcodes. Every field is a 4 byte word, floats are f32 in
+ * buffer pixels and colours are packed as r, g, b, a bytes in one word.
+ *
+ *   COLOR rgba                          CLEAR
+ *   LINE_WIDTH w                        CLIP x y w h (zero size resets)
+ *   RECT x y w h                        LINE x0 y0 x1 y1
+ *   POLYLINE count x0 y0 ...            ARC cx cy r start end fill
+ *   TEXT x y font align baseline count codepoints...
+ *
+ * Angles are radians, clockwise from +x since y points down.
+ */
+enum CommandOp {
+  CMD_COLOR = 1,
+  CMD_CLEAR,
+  CMD_LINE_WIDTH,
+  CMD_CLIP,
+  CMD_RECT,
+  CMD_LINE,
+  CMD_POLYLINE,
+  CMD_ARC,
+  CMD_TEXT
+};
+
+// decodes the whole buffer into render_buffer, stops at the first bad command
+uint8_t execute_commands(UiInstance *instance, const uint8_t *commands,
+                         uint32_t length);
+
+// same as execute_commands but into caller owned "rgb", "rgba" or "bgra"
+// pixels, needs no window so it can run on any thread
+uint8_t rasterize_commands(uint8_t *pixels, uint32_t w, uint32_t h,
+                           const char *type, const uint8_t *commands,
+                           uint32_t length);
+
+// draws words shifted by the offset, clip is x0 y0 x1 y1 or NULL
+uint8_t raster_commands(Image *image, const uint32_t *words, uint32_t count,
+                        float offset_x, float offset_y, const int32_t *clip);
+
+// area the words would touch as x0 y0 x1 y1, empty bounds have x0 > x1
+uint8_t command_bounds(Image *image, const uint32_t *words, uint32_t count,
+                       float *bounds);
+
+// aligned copy of a command buffer, free it with free()
+uint32_t *copy_command_words(const uint8_t *commands, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
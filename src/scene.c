@@ -0,0 +1,298 @@
+#include "scene.h"
+#include "raster.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Scene *get_scene(UiInstance *instance) {
+  if (!instance->scene)
+    instance->scene = calloc(1, sizeof(Scene));
+  return instance->scene;
+}
+
+static SceneNode *get_scene_node(UiInstance *instance, int32_t id) {
+  Scene *scene = instance->scene;
+  if (!scene || id < 0 || (uint32_t)id >= scene->node_count)
+    return NULL;
+  SceneNode *node = &scene->nodes[id];
+  return node->in_use ? node : NULL;
+}
+
+static int64_t rect_area(const int32_t *r) {
+  return (int64_t)(r[2] - r[0]) * (r[3] - r[1]);
+}
+
+static void rect_union(int32_t *into, const int32_t *r) {
+  if (r[0] < into[0])
+    into[0] = r[0];
+  if (r[1] < into[1])
+    into[1] = r[1];
+  if (r[2] > into[2])
+    into[2] = r[2];
+  if (r[3] > into[3])
+    into[3] = r[3];
+}
+
+static uint8_t rects_touch(const int32_t *a, const int32_t *b) {
+  return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+static void add_damage(Scene *scene, const int32_t *rect) {
+  int32_t r[4] = {rect[0], rect[1], rect[2], rect[3]};
+  if (r[0] >= r[2] || r[1] >= r[3])
+    return;
+  // merging can make the result touch rects it missed before
+  for (uint32_t i = 0; i < scene->damage_count;) {
+    if (rects_touch(scene->damage[i], r)) {
+      rect_union(r, scene->damage[i]);
+      memcpy(scene->damage[i], scene->damage[--scene->damage_count],
+             sizeof(r));
+      i = 0;
+      continue;
+    }
+    i++;
+  }
+  if (scene->damage_count < SCENE_MAX_DAMAGE) {
+    memcpy(scene->damage[scene->damage_count++], r, sizeof(r));
+    return;
+  }
+  // out of rects, grow the one that gains the least area
+  uint32_t best = 0;
+  int64_t best_growth = INT64_MAX;
+  for (uint32_t i = 0; i < scene->damage_count; i++) {
+    int32_t merged[4] = {scene->damage[i][0], scene->damage[i][1],
+                         scene->damage[i][2], scene->damage[i][3]};
+    rect_union(merged, r);
+    int64_t growth = rect_area(merged) - rect_area(scene->damage[i]);
+    if (growth < best_growth) {
+      best_growth = growth;
+      best = i;
+    }
+  }
+  int32_t merged[4] = {scene->damage[best][0], scene->damage[best][1],
+                       scene->damage[best][2], scene->damage[best][3]};
+  rect_union(merged, r);
+  memcpy(scene->damage[best], merged, sizeof(merged));
+}
+
+// the pixels the node covers right now, one extra pixel for anti-aliasing
+static uint8_t node_rect(SceneNode *node, int32_t *rect) {
+  if (!node->visible || node->bounds[0] > node->bounds[2])
+    return 0;
+  rect[0] = (int32_t)floorf(node->bounds[0] + node->x) - 1;
+  rect[1] = (int32_t)floorf(node->bounds[1] + node->y) - 1;
+  rect[2] = (int32_t)ceilf(node->bounds[2] + node->x) + 1;
+  rect[3] = (int32_t)ceilf(node->bounds[3] + node->y) + 1;
+  return 1;
+}
+
+static void damage_node(UiInstance *instance, SceneNode *node) {
+  int32_t rect[4];
+  if (node_rect(node, rect))
+    add_damage(instance->scene, rect);
+  instance->needs_render = 1;
+}
+
+int32_t add_scene_node(UiInstance *instance, int32_t z) {
+  Scene *scene = get_scene(instance);
+  if (!scene)
+    return -1;
+  uint32_t id = 0;
+  while (id < scene->node_count && scene->nodes[id].in_use)
+    id++;
+  if (id == scene->node_count) {
+    SceneNode *resized =
+        realloc(scene->nodes, sizeof(SceneNode) * (scene->node_count + 1));
+    if (!resized)
+      return -1;
+    scene->nodes = resized;
+    scene->node_count++;
+  }
+  SceneNode *node = &scene->nodes[id];
+  memset(node, 0, sizeof(SceneNode));
+  node->in_use = 1;
+  node->visible = 1;
+  node->z = z;
+  node->bounds[0] = node->bounds[1] = 1;
+  return id;
+}
+
+uint8_t remove_scene_node(UiInstance *instance, int32_t id) {
+  SceneNode *node = get_scene_node(instance, id);
+  if (!node)
+    return 1;
+  damage_node(instance, node);
+  free(node->commands);
+  memset(node, 0, sizeof(SceneNode));
+  return 0;
+}
+
+uint8_t set_scene_node(UiInstance *instance, int32_t id,
+                       const uint8_t *commands, uint32_t length) {
+  SceneNode *node = get_scene_node(instance, id);
+  if (!node)
+    return 1;
+  uint32_t *copy = NULL;
+  if (length >= 4 && !(copy = copy_command_words(commands, length)))
+    return 1;
+  damage_node(instance, node);
+  free(node->commands);
+  node->commands = copy;
+  node->count = length / 4;
+  uint8_t failed = command_bounds(&instance->render_buffer, node->commands,
+                                  node->count, node->bounds);
+  damage_node(instance, node);
+  return failed;
+}
+
+uint8_t set_scene_node_offset(UiInstance *instance, int32_t id, float x,
+                              float y) {
+  SceneNode *node = get_scene_node(instance, id);
+  if (!node)
+    return 1;
+  if (node->x == x && node->y == y)
+    return 0;
+  damage_node(instance, node);
+  node->x = x;
+  node->y = y;
+  damage_node(instance, node);
+  return 0;
+}
+
+uint8_t set_scene_node_visible(UiInstance *instance, int32_t id,
+                               uint8_t visible) {
+  SceneNode *node = get_scene_node(instance, id);
+  if (!node)
+    return 1;
+  if (node->visible == visible)
+    return 0;
+  node->visible = 1;
+  damage_node(instance, node);
+  node->visible = visible;
+  return 0;
+}
+
+uint8_t set_scene_node_z(UiInstance *instance, int32_t id, int32_t z) {
+  SceneNode *node = get_scene_node(instance, id);
+  if (!node)
+    return 1;
+  if (node->z == z)
+    return 0;
+  node->z = z;
+  damage_node(instance, node);
+  return 0;
+}
+
+uint8_t set_scene_background(UiInstance *instance, uint8_t r, uint8_t g,
+                             uint8_t b, uint8_t a) {
+  Scene *scene = get_scene(instance);
+  if (!scene)
+    return 1;
+  RgbaColor color = {r, g, b, a};
+  scene->background = color;
+  // forces a full redraw on the next update
+  scene->w = 0;
+  instance->needs_render = 1;
+  return 0;
+}
+
+double get_scene_drawn_pixels(UiInstance *instance) {
+  return instance->scene ? (double)instance->scene->drawn_pixels : 0;
+}
+
+static void clear_rect(Scene *scene, Image *image, const int32_t *rect) {
+  const uint8_t pixel_size = get_buffer_pixel_size(image);
+  RgbaColor c = scene->background;
+  uint8_t pixel[4] = {c.r, c.g, c.b, c.a};
+  if (image->type == BGRA) {
+    pixel[0] = c.b;
+    pixel[2] = c.r;
+  }
+  const size_t row_size = (size_t)(rect[2] - rect[0]) * pixel_size;
+  uint8_t *first = image->buffer +
+                   ((size_t)rect[1] * image->w + rect[0]) * pixel_size;
+  for (int32_t x = 0; x < rect[2] - rect[0]; x++)
+    memcpy(first + (size_t)x * pixel_size, pixel, pixel_size);
+  for (int32_t y = rect[1] + 1; y < rect[3]; y++)
+    memcpy(image->buffer + ((size_t)y * image->w + rect[0]) * pixel_size,
+           first, row_size);
+}
+
+static int compare_nodes(const void *lhs, const void *rhs) {
+  const SceneNode *a = *(SceneNode *const *)lhs;
+  const SceneNode *b = *(SceneNode *const *)rhs;
+  if (a->z != b->z)
+    return a->z < b->z ? -1 : 1;
+  // equal z keeps insertion order
+  return a < b ? -1 : a > b;
+}
+
+void update_scene(UiInstance *instance) {
+  Scene *scene = instance->scene;
+  Image *image = &instance->render_buffer;
+  if (!image->buffer || !image_is_color(image))
+    return;
+  uint8_t full = scene->w != image->w || scene->h != image->h ||
+                 scene->type != image->type;
+  if (full) {
+    scene->damage[0][0] = 0;
+    scene->damage[0][1] = 0;
+    scene->damage[0][2] = image->w;
+    scene->damage[0][3] = image->h;
+    scene->damage_count = 1;
+    scene->w = image->w;
+    scene->h = image->h;
+    scene->type = image->type;
+  }
+  scene->drawn_pixels = 0;
+  if (scene->damage_count == 0)
+    return;
+  SceneNode **order = malloc(sizeof(SceneNode *) * (scene->node_count + 1));
+  if (!order)
+    return;
+  uint32_t visible = 0;
+  for (uint32_t i = 0; i < scene->node_count; i++) {
+    if (scene->nodes[i].in_use && scene->nodes[i].visible)
+      order[visible++] = &scene->nodes[i];
+  }
+  qsort(order, visible, sizeof(SceneNode *), compare_nodes);
+  for (uint32_t d = 0; d < scene->damage_count; d++) {
+    int32_t *rect = scene->damage[d];
+    if (rect[0] < 0)
+      rect[0] = 0;
+    if (rect[1] < 0)
+      rect[1] = 0;
+    if (rect[2] > (int32_t)image->w)
+      rect[2] = image->w;
+    if (rect[3] > (int32_t)image->h)
+      rect[3] = image->h;
+    if (rect[0] >= rect[2] || rect[1] >= rect[3])
+      continue;
+    clear_rect(scene, image, rect);
+    for (uint32_t i = 0; i < visible; i++) {
+      int32_t node[4];
+      if (node_rect(order[i], node) && rects_touch(node, rect))
+        raster_commands(image, order[i]->commands, order[i]->count,
+                        order[i]->x, order[i]->y, rect);
+    }
+    scene->drawn_pixels += rect_area(rect);
+    if (!full)
+      image_upload_rect(image, rect[0], rect[1], rect[2] - rect[0],
+                        rect[3] - rect[1]);
+  }
+  free(order);
+  scene->damage_count = 0;
+  if (full)
+    image->dirty = 1;
+}
+
+void dispose_scene(UiInstance *instance) {
+  Scene *scene = instance->scene;
+  if (!scene)
+    return;
+  for (uint32_t i = 0; i < scene->node_count; i++)
+    free(scene->nodes[i].commands);
+  free(scene->nodes);
+  free(scene);
+  instance->scene = NULL;
+}
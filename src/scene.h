@@ -0,0 +1,64 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCENE_MAX_DAMAGE 32
+
+typedef struct SceneNode {
+  uint8_t in_use;
+  uint8_t visible;
+  int32_t z;
+  // translation applied to all commands, moving a node keeps its commands
+  float x, y;
+  uint32_t *commands;
+  uint32_t count;
+  // untranslated x0 y0 x1 y1 of what the commands touch, x0 > x1 if empty
+  float bounds[4];
+} SceneNode;
+
+/*
+ * Retained drawing into render_buffer. Nodes hold command buffers (see
+ * raster.h), every change to a node damages the area it covered before and
+ * after. Damaged rects are merged, cleared to the background, redrawn from
+ * the nodes that intersect them and only those rects are uploaded.
+ */
+typedef struct Scene {
+  SceneNode *nodes;
+  uint32_t node_count;
+  RgbaColor background;
+  // x0 y0 x1 y1 in buffer pixels
+  int32_t damage[SCENE_MAX_DAMAGE][4];
+  uint32_t damage_count;
+  // buffer layout of the last update, any change redraws everything
+  uint32_t w, h;
+  enum ImageType type;
+  // pixels drawn by the last update, for profiling
+  uint64_t drawn_pixels;
+} Scene;
+
+int32_t add_scene_node(UiInstance *instance, int32_t z);
+uint8_t remove_scene_node(UiInstance *instance, int32_t id);
+uint8_t set_scene_node(UiInstance *instance, int32_t id,
+                       const uint8_t *commands, uint32_t length);
+uint8_t set_scene_node_offset(UiInstance *instance, int32_t id, float x,
+                              float y);
+uint8_t set_scene_node_visible(UiInstance *instance, int32_t id,
+                               uint8_t visible);
+uint8_t set_scene_node_z(UiInstance *instance, int32_t id, int32_t z);
+uint8_t set_scene_background(UiInstance *instance, uint8_t r, uint8_t g,
+                             uint8_t b, uint8_t a);
+double get_scene_drawn_pixels(UiInstance *instance);
+
+// redraws and uploads the damaged rects, called before the frame is drawn
+void update_scene(UiInstance *instance);
+void dispose_scene(UiInstance *instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+#include "series.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const RgbaColor series_default_colors[] = {
+    {0, 50, 200, 255},  {200, 50, 0, 255},   {0, 150, 50, 255},
+    {150, 0, 150, 255}, {200, 150, 0, 255},  {0, 150, 150, 255},
+    {90, 90, 90, 255},  {200, 100, 150, 255}};
+
+SeriesStore *create_series_store(uint32_t capacity, uint32_t channels,
+                                 uint8_t is_double) {
+  if (capacity == 0 || channels == 0)
+    return NULL;
+  SeriesStore *store = calloc(1, sizeof(SeriesStore));
+  store->capacity = capacity;
+  store->channels = channels;
+  store->is_double = is_double ? 1 : 0;
+  store->timestamps = calloc(capacity, sizeof(double));
+  store->values = calloc((size_t)capacity * channels,
+                         is_double ? sizeof(double) : sizeof(float));
+  store->colors = calloc(channels, sizeof(RgbaColor));
+  store->last_row = calloc(channels, sizeof(float));
+  const size_t palette_len =
+      sizeof(series_default_colors) / sizeof(series_default_colors[0]);
+  for (uint32_t i = 0; i < channels; i++)
+    store->colors[i] = series_default_colors[i % palette_len];
+  return store;
+}
+
+uint8_t dispose_series_store(SeriesStore *store) {
+  free(store->timestamps);
+  free(store->values);
+  free(store->colors);
+  free(store->last_row);
+  free(store);
+  return 0;
+}
+
+uint8_t series_append(SeriesStore *store, const double *timestamps,
+                      const void *values, uint32_t count) {
+  const size_t sample_size = (size_t)store->channels *
+                             (store->is_double ? sizeof(double) : sizeof(float));
+  const uint8_t *in = values;
+  uint64_t first = store->total;
+  // only the newest capacity samples of an oversized batch survive anyway
+  if (count > store->capacity) {
+    uint32_t skip = count - store->capacity;
+    in += skip * sample_size;
+    if (timestamps)
+      timestamps += skip;
+    first += skip;
+    store->total += skip;
+    count = store->capacity;
+  }
+  uint32_t written = 0;
+  while (written < count) {
+    uint32_t chunk = store->capacity - store->head;
+    if (chunk > count - written)
+      chunk = count - written;
+    memcpy((uint8_t *)store->values + store->head * sample_size,
+           in + written * sample_size, chunk * sample_size);
+    if (timestamps) {
+      memcpy(store->timestamps + store->head, timestamps + written,
+             chunk * sizeof(double));
+    } else {
+      for (uint32_t i = 0; i < chunk; i++)
+        store->timestamps[store->head + i] = (double)(first + written + i);
+    }
+    written += chunk;
+    store->head = (store->head + chunk) % store->capacity;
+  }
+  store->total += count;
+  store->count = store->count + count > store->capacity ? store->capacity
+                                                        : store->count + count;
+  return 0;
+}
+
+uint8_t series_set_color(SeriesStore *store, uint32_t channel, uint8_t r,
+                         uint8_t g, uint8_t b) {
+  if (channel >= store->channels)
+    return 1;
+  RgbaColor color = {.r = r, .g = g, .b = b, .a = 255};
+  store->colors[channel] = color;
+  // colours are baked into the pixels, force a full redraw
+  store->rendered_image = NULL;
+  return 0;
+}
+
+static double series_value(SeriesStore *store, uint64_t sample,
+                           uint32_t channel) {
+  size_t index = (size_t)(sample % store->capacity) * store->channels + channel;
+  if (store->is_double)
+    return ((double *)store->values)[index];
+  return ((float *)store->values)[index];
+}
+
+uint32_t series_read(SeriesStore *store, uint32_t channel, uint32_t max,
+                     double *values, double *timestamps) {
+  if (channel >= store->channels)
+    return 0;
+  uint32_t n = max < store->count ? max : store->count;
+  uint64_t start = store->total - n;
+  for (uint32_t i = 0; i < n; i++) {
+    if (values)
+      values[i] = series_value(store, start + i, channel);
+    if (timestamps)
+      timestamps[i] = store->timestamps[(start + i) % store->capacity];
+  }
+  return n;
+}
+
+static void series_fill_column(Image *image, uint32_t x, int32_t from,
+                               int32_t to, RgbaColor color) {
+  const uint8_t pixel_size = get_buffer_pixel_size(image);
+  if (from < 0)
+    from = 0;
+  if (to >= (int32_t)image->h)
+    to = image->h - 1;
+  for (int32_t y = from; y <= to; y++) {
+    uint8_t *p = image->buffer + ((size_t)y * image->w + x) * pixel_size;
+    if (image->type == BGRA) {
+      p[0] = color.b;
+      p[1] = color.g;
+      p[2] = color.r;
+    } else {
+      p[0] = color.r;
+      p[1] = color.g;
+      p[2] = color.b;
+    }
+    if (pixel_size == 4)
+      p[3] = color.a;
+  }
+}
+
+static void series_draw_column(Image *image, SeriesStore *store, uint32_t x,
+                               uint64_t column, uint32_t spc, double y_min,
+                               double y_max) {
+  const uint64_t first = column * spc;
+  const double scale = (double)(image->h - 1) / (y_max - y_min);
+  // part of the column was already overwritten in the ring
+  if (first < store->total - store->count) {
+    for (uint32_t c = 0; c < store->channels; c++)
+      store->last_row[c] = NAN;
+    return;
+  }
+  for (uint32_t c = 0; c < store->channels; c++) {
+    float lo = INFINITY, hi = -INFINITY, row = NAN;
+    for (uint32_t i = 0; i < spc; i++) {
+      row = (float)((y_max - series_value(store, first + i, c)) * scale);
+      if (row < lo)
+        lo = row;
+      if (row > hi)
+        hi = row;
+    }
+    // join with the previous column so steep edges stay connected
+    float prev = store->last_row[c];
+    if (!isnan(prev)) {
+      if (prev < lo)
+        lo = prev;
+      if (prev > hi)
+        hi = prev;
+    }
+    store->last_row[c] = row;
+    if (isnan(lo) || hi < 0 || lo > (float)(image->h - 1))
+      continue;
+    series_fill_column(image, x, (int32_t)lrintf(lo), (int32_t)lrintf(hi),
+                       store->colors[c]);
+  }
+}
+
+uint8_t series_render_scroll(UiInstance *instance, SeriesStore *store,
+                             double y_min, double y_max,
+                             uint32_t samples_per_column) {
+  Image *image = &instance->render_buffer;
+  if (!image->buffer || image->w == 0 || image->h == 0 || y_max == y_min)
+    return 1;
+  if (image->type != RGB && image->type != RGBA && image->type != BGRA)
+    return 1;
+  const uint32_t spc = samples_per_column ? samples_per_column : 1;
+  const uint32_t w = image->w, h = image->h;
+  const uint8_t pixel_size = get_buffer_pixel_size(image);
+  const size_t row_size = (size_t)w * pixel_size;
+  const uint64_t end_column = store->total / spc;
+  uint64_t start_column = store->rendered_total / spc;
+
+  uint8_t full = store->rendered_image != image || store->rendered_w != w ||
+                 store->rendered_h != h || store->rendered_spc != spc ||
+                 store->rendered_min != y_min || store->rendered_max != y_max ||
+                 end_column - start_column >= w || end_column < start_column;
+  uint32_t shift = (uint32_t)(end_column - start_column);
+  if (full) {
+    start_column = end_column > w ? end_column - w : 0;
+    shift = w;
+    for (uint32_t c = 0; c < store->channels; c++)
+      store->last_row[c] = NAN;
+  } else if (shift == 0) {
+    return 0;
+  }
+
+  RgbaColor clear = instance->clear_color;
+  for (uint32_t y = 0; y < h; y++) {
+    uint8_t *row = image->buffer + y * row_size;
+    if (shift < w)
+      memmove(row, row + (size_t)shift * pixel_size,
+              (size_t)(w - shift) * pixel_size);
+  }
+  for (uint32_t x = w - shift; x < w; x++)
+    series_fill_column(image, x, 0, h - 1, clear);
+  for (uint64_t column = start_column; column < end_column; column++)
+    series_draw_column(image, store, w - (uint32_t)(end_column - column),
+                       column, spc, y_min, y_max);
+
+  image->dirty = 1;
+  store->rendered_image = image;
+  store->rendered_total = end_column * spc;
+  store->rendered_w = w;
+  store->rendered_h = h;
+  store->rendered_spc = spc;
+  store->rendered_min = y_min;
+  store->rendered_max = y_max;
+  return 0;
+}
+
+#define DECIMATE(T)                                                            \
+  for (uint32_t b = 0; b < buckets; b++) {                                     \
+    const T *in = values;                                                      \
+    T *minmax = (T *)out + (size_t)b * 2;                                      \
+    size_t start = (size_t)count * b / buckets;                                \
+    size_t end = (size_t)count * (b + 1) / buckets;                            \
+    T lo = NAN, hi = NAN;                                                      \
+    for (size_t i = start; i < end; i++) {                                     \
+      T v = in[i];                                                             \
+      if (v < lo || isnan(lo))                                                 \
+        lo = v;                                                                \
+      if (v > hi || isnan(hi))                                                 \
+        hi = v;                                                                \
+    }                                                                          \
+    minmax[0] = lo;                                                            \
+    minmax[1] = hi;                                                            \
+  }
+
+uint8_t decimate_minmax(const void *values, uint8_t is_double, uint32_t count,
+                        uint32_t buckets, void *out) {
+  if (buckets == 0)
+    return 1;
+  if (is_double) {
+    DECIMATE(double)
+  } else {
+    DECIMATE(float)
+  }
+  return 0;
+}
+#undef DECIMATE
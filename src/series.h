@@ -0,0 +1,62 @@
+#ifndef SERIES_H
+#define SERIES_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed capacity ring buffer of multi channel samples. Values are stored
+ * interleaved per sample ([sample][channel]) as float or double.
+ */
+typedef struct {
+  uint32_t capacity;
+  uint32_t channels;
+  uint8_t is_double;
+  uint32_t head;
+  uint32_t count;
+  uint64_t total;
+  double *timestamps;
+  void *values;
+  RgbaColor *colors;
+  // state of the last series_render_scroll call
+  uint64_t rendered_total;
+  uint32_t rendered_w, rendered_h;
+  uint32_t rendered_spc;
+  double rendered_min, rendered_max;
+  float *last_row;
+  Image *rendered_image;
+} SeriesStore;
+
+SeriesStore *create_series_store(uint32_t capacity, uint32_t channels,
+                                 uint8_t is_double);
+
+uint8_t dispose_series_store(SeriesStore *store);
+
+uint8_t series_append(SeriesStore *store, const double *timestamps,
+                      const void *values, uint32_t count);
+
+uint8_t series_set_color(SeriesStore *store, uint32_t channel, uint8_t r,
+                         uint8_t g, uint8_t b);
+
+uint32_t series_read(SeriesStore *store, uint32_t channel, uint32_t max,
+                     double *values, double *timestamps);
+
+/*
+ * Min and max of each of the buckets evenly splitting count values, written
+ * as min0 max0 min1 max1 ... in the type of the input. NaN values are
+ * skipped and buckets without values get NaN.
+ */
+uint8_t decimate_minmax(const void *values, uint8_t is_double, uint32_t count,
+                        uint32_t buckets, void *out);
+
+uint8_t series_render_scroll(UiInstance *instance, SeriesStore *store,
+                             double y_min, double y_max,
+                             uint32_t samples_per_column);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
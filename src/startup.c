@@ -0,0 +1,107 @@
+#include "startup.h"
+#include "program.h"
+#include "upload.h"
+#include <string.h>
+#include <time.h>
+#if !defined(__APPLE__) && !defined(_WIN32)
+#include <pthread.h>
+#define PREWARM_THREAD
+#endif
+
+static double g_timings[STARTUP_TIMING_COUNT];
+static uint8_t g_gl_loaded = 0;
+static uint8_t g_prewarmed = 0;
+#ifdef PREWARM_THREAD
+static pthread_t g_prewarm_thread;
+static uint8_t g_prewarm_running = 0;
+#endif
+
+double startup_now() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// only the first run of every step is kept
+void startup_record(StartupTiming timing, double start) {
+  if (g_timings[timing] == 0)
+    g_timings[timing] = startup_now() - start;
+}
+
+// needs a current context, the pointers are the same for every context
+uint8_t load_gl() {
+  if (g_gl_loaded)
+    return 0;
+  double start = startup_now();
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    return 1;
+  g_gl_loaded = 1;
+  startup_record(STARTUP_GL_LOAD, start);
+  return 0;
+}
+
+static void warm_programs() {
+  double start = startup_now();
+  shared_program(IMAGE_SHADER_VERT, IMAGE_SHADER_FRAG);
+  shared_program(IMAGE_SHADER_VERT, SCALAR_SHADER_FRAG);
+  shared_program(IMAGE_SHADER_VERT, SCALAR_UINT_SHADER_FRAG);
+  shared_program(IMAGE_SHADER_VERT, INDEXED_SHADER_FRAG);
+  shared_program(LINE_SHADER_VERT, LINE_SHADER_FRAG);
+  shared_program(SCATTER_SHADER_VERT, SCATTER_SHADER_FRAG);
+  shared_program(DENSITY_SHADER_VERT, DENSITY_SHADER_FRAG);
+  shared_program(TEXT_SHADER_VERT, TEXT_SHADER_FRAG);
+  // linking can be deferred by the driver until the program is first used
+  glFinish();
+  startup_record(STARTUP_PROGRAMS, start);
+}
+
+static void *warm_share_context(void *share) {
+  glfwMakeContextCurrent(share);
+  if (!load_gl()) {
+    warm_programs();
+    upload_calibrate();
+  }
+  glfwMakeContextCurrent(NULL);
+  return NULL;
+}
+
+uint8_t prewarm(uint8_t threaded) {
+  prewarm_wait();
+  if (bun_ui_init())
+    return 1;
+  double start = startup_now();
+  GLFWwindow *share = share_window();
+  if (!share)
+    return 1;
+  startup_record(STARTUP_SHARE_CONTEXT, start);
+  if (g_prewarmed)
+    return 0;
+  g_prewarmed = 1;
+  // the share context is never current on the main thread, so the helper
+  // can take it without giving anything up
+#ifdef PREWARM_THREAD
+  if (threaded &&
+      pthread_create(&g_prewarm_thread, NULL, warm_share_context, share) == 0) {
+    g_prewarm_running = 1;
+    return 0;
+  }
+#endif
+  GLFWwindow *current = glfwGetCurrentContext();
+  warm_share_context(share);
+  glfwMakeContextCurrent(current);
+  return 0;
+}
+
+void prewarm_wait() {
+#ifdef PREWARM_THREAD
+  if (!g_prewarm_running)
+    return;
+  pthread_join(g_prewarm_thread, NULL);
+  g_prewarm_running = 0;
+#endif
+}
+
+uint8_t get_startup_timings(double *out) {
+  memcpy(out, g_timings, sizeof(g_timings));
+  return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// durations in milliseconds, zero for steps that did not run yet
+typedef enum {
+  STARTUP_INIT,
+  STARTUP_SHARE_CONTEXT,
+  STARTUP_GL_LOAD,
+  STARTUP_PROGRAMS,
+  STARTUP_FIRST_WINDOW,
+  STARTUP_FIRST_FRAME,
+  STARTUP_UPLOAD_PROBE,
+  STARTUP_TIMING_COUNT
+} StartupTiming;
+
+double startup_now();
+
+void startup_record(StartupTiming timing, double start);
+
+uint8_t load_gl();
+
+/*
+ * Initializes glfw and the share window, then loads the GL functions and
+ * links the builtin programs. With threaded set the GL part runs on a helper
+ * thread on the share context while the caller keeps going, on macOS and
+ * Windows it always runs in place.
+ */
+uint8_t prewarm(uint8_t threaded);
+
+// blocks until a threaded prewarm is done, called before any window is made
+void prewarm_wait();
+
+uint8_t get_startup_timings(double *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
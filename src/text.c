@@ -0,0 +1,401 @@
+#include "text.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+static SRWLOCK g_lock = SRWLOCK_INIT;
+#define lock_shared() AcquireSRWLockShared(&g_lock)
+#define unlock_shared() ReleaseSRWLockShared(&g_lock)
+#define lock_exclusive() AcquireSRWLockExclusive(&g_lock)
+#define unlock_exclusive() ReleaseSRWLockExclusive(&g_lock)
+#else
+#include <pthread.h>
+static pthread_rwlock_t g_lock = PTHREAD_RWLOCK_INITIALIZER;
+#define lock_shared() pthread_rwlock_rdlock(&g_lock)
+#define unlock_shared() pthread_rwlock_unlock(&g_lock)
+#define lock_exclusive() pthread_rwlock_wrlock(&g_lock)
+#define unlock_exclusive() pthread_rwlock_unlock(&g_lock)
+#endif
+
+#define ATLAS_SIZE 2048
+#define MAX_FONTS 2047
+// anchor, offset, size and uv rect of a glyph quad
+#define GLYPH_STRIDE 10
+
+static Font *g_fonts = NULL;
+static uint32_t g_font_count = 0;
+// open addressing table, a zero key marks an empty slot
+static Glyph *g_glyphs = NULL;
+static uint32_t g_glyph_capacity = 0;
+static uint32_t g_glyph_count = 0;
+static GLuint g_atlas = 0;
+// cpu copy of the atlas for text drawn into images, see raster.c
+static uint8_t *g_atlas_pixels = NULL;
+// part of the cpu copy the texture is missing, x0 y0 x1 y1
+static uint32_t g_atlas_dirty[4] = {ATLAS_SIZE, ATLAS_SIZE, 0, 0};
+static uint32_t g_shelf_x = 0, g_shelf_y = 0, g_shelf_h = 0;
+
+static uint32_t glyph_key(uint32_t font, uint32_t codepoint) {
+  // codepoints fit into 21 bits, font + 1 keeps the key non zero
+  return ((font + 1) << 21) | (codepoint & 0x1fffff);
+}
+
+static Glyph *find_slot(Glyph *table, uint32_t capacity, uint32_t key) {
+  uint32_t i = (key * 2654435761u) & (capacity - 1);
+  while (table[i].key && table[i].key != key)
+    i = (i + 1) & (capacity - 1);
+  return &table[i];
+}
+
+Glyph *text_glyph(uint32_t font, uint32_t codepoint) {
+  if (!g_glyph_capacity)
+    return NULL;
+  Glyph *glyph =
+      find_slot(g_glyphs, g_glyph_capacity, glyph_key(font, codepoint));
+  return glyph->key ? glyph : NULL;
+}
+
+static uint8_t grow_glyphs() {
+  uint32_t capacity = g_glyph_capacity ? g_glyph_capacity * 2 : 256;
+  Glyph *table = calloc(capacity, sizeof(Glyph));
+  if (!table)
+    return 1;
+  for (uint32_t i = 0; i < g_glyph_capacity; i++) {
+    if (g_glyphs[i].key)
+      *find_slot(table, capacity, g_glyphs[i].key) = g_glyphs[i];
+  }
+  free(g_glyphs);
+  g_glyphs = table;
+  g_glyph_capacity = capacity;
+  return 0;
+}
+
+void atlas_lock_shared() { lock_shared(); }
+
+void atlas_unlock_shared() { unlock_shared(); }
+
+int32_t add_font(float ascent, float descent) {
+  if (g_font_count == MAX_FONTS)
+    return -1;
+  lock_exclusive();
+  Font *resized = realloc(g_fonts, sizeof(Font) * (g_font_count + 1));
+  if (!resized) {
+    unlock_exclusive();
+    return -1;
+  }
+  g_fonts = resized;
+  g_fonts[g_font_count].ascent = ascent;
+  g_fonts[g_font_count].descent = descent;
+  int32_t id = g_font_count++;
+  unlock_exclusive();
+  return id;
+}
+
+uint8_t atlas_has_glyph(uint32_t font, uint32_t codepoint) {
+  return text_glyph(font, codepoint) != NULL;
+}
+
+// shelves of glyphs, a new shelf starts when the current row is full
+static uint8_t atlas_pack(uint32_t w, uint32_t h, uint32_t *x, uint32_t *y) {
+  if (w + 1 > ATLAS_SIZE || h + 1 > ATLAS_SIZE)
+    return 1;
+  if (g_shelf_x + w + 1 > ATLAS_SIZE) {
+    g_shelf_y += g_shelf_h;
+    g_shelf_x = 0;
+    g_shelf_h = 0;
+  }
+  if (g_shelf_y + h + 1 > ATLAS_SIZE)
+    return 1;
+  *x = g_shelf_x;
+  *y = g_shelf_y;
+  g_shelf_x += w + 1;
+  if (h + 1 > g_shelf_h)
+    g_shelf_h = h + 1;
+  return 0;
+}
+
+// uploads what the cpu copy gained since the last sync, needs a context
+static void atlas_sync() {
+  if (!g_atlas_pixels)
+    return;
+  if (!g_atlas) {
+    // created in a window context but owned by the whole share group
+    glGenTextures(1, &g_atlas);
+    glBindTexture(GL_TEXTURE_2D, g_atlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RED,
+                 GL_UNSIGNED_BYTE, NULL);
+  }
+  uint32_t *d = g_atlas_dirty;
+  if (d[0] >= d[2] || d[1] >= d[3])
+    return;
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, g_atlas);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, ATLAS_SIZE);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, d[0], d[1], d[2] - d[0], d[3] - d[1],
+                  GL_RED, GL_UNSIGNED_BYTE,
+                  g_atlas_pixels + (size_t)d[1] * ATLAS_SIZE + d[0]);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  // other contexts of the group sample it in the same frame
+  glFlush();
+  d[0] = d[1] = ATLAS_SIZE;
+  d[2] = d[3] = 0;
+}
+
+/*
+ * Raster workers read the table and the cpu copy under the shared lock, so
+ * everything they can see is changed under the exclusive one.
+ */
+static uint8_t atlas_insert(uint32_t font, uint32_t codepoint,
+                            const uint8_t *alpha, uint32_t w, uint32_t h,
+                            float bearing_x, float bearing_y, float advance) {
+  if ((g_glyph_count + 1) * 10 > g_glyph_capacity * 7 && grow_glyphs())
+    return 1;
+  uint32_t x = 0, y = 0;
+  // blank glyphs like spaces only need their advance
+  if (w && h && atlas_pack(w, h, &x, &y))
+    return 1;
+  if (!g_atlas_pixels && !(g_atlas_pixels = calloc(ATLAS_SIZE, ATLAS_SIZE)))
+    return 1;
+  for (uint32_t row = 0; row < h; row++)
+    memcpy(g_atlas_pixels + (size_t)(y + row) * ATLAS_SIZE + x,
+           alpha + (size_t)row * w, w);
+  if (w && h) {
+    uint32_t *d = g_atlas_dirty;
+    d[0] = x < d[0] ? x : d[0];
+    d[1] = y < d[1] ? y : d[1];
+    d[2] = x + w > d[2] ? x + w : d[2];
+    d[3] = y + h > d[3] ? y + h : d[3];
+  }
+  Glyph *glyph =
+      find_slot(g_glyphs, g_glyph_capacity, glyph_key(font, codepoint));
+  glyph->key = glyph_key(font, codepoint);
+  glyph->x = x;
+  glyph->y = y;
+  glyph->w = w;
+  glyph->h = h;
+  glyph->bearing_x = bearing_x;
+  glyph->bearing_y = bearing_y;
+  glyph->advance = advance;
+  g_glyph_count++;
+  return 0;
+}
+
+uint8_t atlas_add_glyph(UiInstance *instance, uint32_t font,
+                        uint32_t codepoint, const uint8_t *alpha, uint32_t w,
+                        uint32_t h, float bearing_x, float bearing_y,
+                        float advance) {
+  // only this thread adds glyphs, the lookup needs no lock
+  if (font >= g_font_count || text_glyph(font, codepoint))
+    return 1;
+  lock_exclusive();
+  uint8_t failed = atlas_insert(font, codepoint, alpha, w, h, bearing_x,
+                                bearing_y, advance);
+  unlock_exclusive();
+  // without a window the texture catches up when text is drawn next
+  if (!failed && instance) {
+    glfwMakeContextCurrent(instance->window);
+    atlas_sync();
+  }
+  return failed;
+}
+
+// glyphs that were never added count as zero width
+float measure_text(uint32_t font, const uint32_t *codepoints, uint32_t count) {
+  float width = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Glyph *glyph = text_glyph(font, codepoints[i]);
+    if (glyph)
+      width += glyph->advance;
+  }
+  return width;
+}
+
+const uint8_t *atlas_pixels() { return g_atlas_pixels; }
+
+uint32_t atlas_size() { return ATLAS_SIZE; }
+
+// pen position of the first glyph and the baseline offset for the anchor
+float text_origin(uint32_t font, const uint32_t *codepoints, uint32_t count,
+                  uint8_t align, uint8_t baseline, float *base) {
+  Font *metrics = &g_fonts[font];
+  *base = 0;
+  if (baseline == TEXT_TOP)
+    *base = metrics->ascent;
+  else if (baseline == TEXT_MIDDLE)
+    *base = (metrics->ascent - metrics->descent) / 2;
+  if (align == TEXT_CENTER)
+    return -measure_text(font, codepoints, count) / 2;
+  if (align == TEXT_RIGHT)
+    return -measure_text(font, codepoints, count);
+  return 0;
+}
+
+uint8_t text_font_exists(uint32_t font) { return font < g_font_count; }
+
+static TextItem *get_text(UiInstance *instance, int32_t id) {
+  if (id < 0 || (uint32_t)id >= instance->text_count)
+    return NULL;
+  TextItem *item = &instance->texts[id];
+  return item->in_use ? item : NULL;
+}
+
+int32_t add_text(UiInstance *instance) {
+  uint32_t id = 0;
+  while (id < instance->text_count && instance->texts[id].in_use)
+    id++;
+  if (id == instance->text_count) {
+    TextItem *resized =
+        realloc(instance->texts, sizeof(TextItem) * (instance->text_count + 1));
+    if (!resized)
+      return -1;
+    instance->texts = resized;
+    instance->text_count++;
+  }
+  TextItem *item = &instance->texts[id];
+  memset(item, 0, sizeof(TextItem));
+  item->in_use = 1;
+  item->visible = 1;
+  RgbaColor color = {.r = 0, .g = 0, .b = 0, .a = 255};
+  item->color = color;
+  return id;
+}
+
+uint8_t remove_text(UiInstance *instance, int32_t id) {
+  TextItem *item = get_text(instance, id);
+  if (!item)
+    return 1;
+  glfwMakeContextCurrent(instance->window);
+  point_buffer_free(&item->glyphs);
+  memset(item, 0, sizeof(TextItem));
+  instance->needs_render = 1;
+  return 0;
+}
+
+void dispose_texts(UiInstance *instance) {
+  for (uint32_t i = 0; i < instance->text_count; i++)
+    remove_text(instance, i);
+  free(instance->texts);
+  instance->texts = NULL;
+  instance->text_count = 0;
+  if (instance->text_shader)
+    dispose_shader(instance->text_shader);
+  instance->text_shader = NULL;
+}
+
+/*
+ * The string is laid out once from the cached advances, the quads only move
+ * with the anchor when the window is resized or the view changes.
+ */
+uint8_t set_text(UiInstance *instance, int32_t id, uint32_t font,
+                 const uint32_t *codepoints, uint32_t count, float x, float y,
+                 uint8_t align, uint8_t baseline) {
+  TextItem *item = get_text(instance, id);
+  if (!item || font >= g_font_count)
+    return 1;
+  if (item->glyphs.capacity < count || !item->glyphs.data) {
+    glfwMakeContextCurrent(instance->window);
+    point_buffer_free(&item->glyphs);
+    if (point_buffer_init(&item->glyphs, GLYPH_STRIDE, count ? count : 1))
+      return 1;
+  }
+  item->glyphs.count = 0;
+  item->glyphs.uploaded = 0;
+  float base;
+  float pen = text_origin(font, codepoints, count, align, baseline, &base);
+  const float texel = 1.0f / ATLAS_SIZE;
+  for (uint32_t i = 0; i < count; i++) {
+    Glyph *glyph = text_glyph(font, codepoints[i]);
+    if (!glyph)
+      continue;
+    if (glyph->w && glyph->h) {
+      float quad[GLYPH_STRIDE] = {x,
+                                  y,
+                                  pen + glyph->bearing_x,
+                                  base - glyph->bearing_y,
+                                  glyph->w,
+                                  glyph->h,
+                                  glyph->x * texel,
+                                  glyph->y * texel,
+                                  glyph->w * texel,
+                                  glyph->h * texel};
+      point_buffer_append(&item->glyphs, quad, 1);
+    }
+    pen += glyph->advance;
+  }
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_text_style(UiInstance *instance, int32_t id, uint8_t r, uint8_t g,
+                       uint8_t b, uint8_t a) {
+  TextItem *item = get_text(instance, id);
+  if (!item)
+    return 1;
+  RgbaColor color = {.r = r, .g = g, .b = b, .a = a};
+  item->color = color;
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_text_visible(UiInstance *instance, int32_t id, uint8_t visible) {
+  TextItem *item = get_text(instance, id);
+  if (!item)
+    return 1;
+  item->visible = visible;
+  instance->needs_render = 1;
+  return 0;
+}
+
+void render_texts(UiInstance *instance, Vec4f transform) {
+  if (instance->text_count == 0)
+    return;
+  atlas_sync();
+  if (!g_atlas)
+    return;
+  if (!instance->text_shader) {
+    const GLsizei stride = sizeof(float) * GLYPH_STRIDE;
+    ShaderVar vars[4] = {
+        {2, stride, GL_FLOAT, (void *)0},
+        {2, stride, GL_FLOAT, (void *)(sizeof(float) * 2)},
+        {2, stride, GL_FLOAT, (void *)(sizeof(float) * 4)},
+        {4, stride, GL_FLOAT, (void *)(sizeof(float) * 6)}};
+    instance->text_shader =
+        create_shader(TEXT_SHADER_VERT, TEXT_SHADER_FRAG, 0, vars, 4);
+  }
+  Shader *shader = instance->text_shader;
+  shader_use(shader);
+  shader_set2f(shader, "resolution", (float)instance->window_width,
+               (float)instance->window_height);
+  shader_set4f(shader, "transform", transform.x, transform.y, transform.z,
+               transform.w);
+  shader_set1i(shader, "atlas", 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, g_atlas);
+  glDisable(GL_CULL_FACE);
+  for (uint32_t i = 0; i < instance->text_count; i++) {
+    TextItem *item = &instance->texts[i];
+    if (!item->in_use || !item->visible || item->glyphs.count == 0)
+      continue;
+    point_buffer_upload(&item->glyphs);
+    const GLsizei stride = sizeof(float) * GLYPH_STRIDE;
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(sizeof(float) * 2));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(sizeof(float) * 4));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(sizeof(float) * 6));
+    RgbaColor color = item->color;
+    shader_set4f(shader, "text_color", (float)color.r / 255,
+                 (float)color.g / 255, (float)color.b / 255,
+                 (float)color.a / 255);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, item->glyphs.count);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glEnable(GL_CULL_FACE);
+}
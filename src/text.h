@@ -0,0 +1,81 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum TextAlign { TEXT_LEFT, TEXT_CENTER, TEXT_RIGHT };
+enum TextBaseline { TEXT_ALPHABETIC, TEXT_TOP, TEXT_MIDDLE };
+
+/*
+ * Glyph bitmaps are rasterized once by the caller and packed into a single
+ * alpha atlas shared by all windows. Bearings are in pixels from the pen
+ * position, bearing_y points up from the baseline to the top of the bitmap.
+ */
+typedef struct {
+  uint32_t key;
+  uint16_t x, y, w, h;
+  float bearing_x, bearing_y, advance;
+} Glyph;
+
+typedef struct {
+  float ascent, descent;
+} Font;
+
+// one laid out string, drawn as one instanced quad per glyph
+typedef struct TextItem {
+  uint8_t in_use;
+  uint8_t visible;
+  RgbaColor color;
+  PointBuffer glyphs;
+} TextItem;
+
+int32_t add_font(float ascent, float descent);
+
+/*
+ * Fonts and glyphs are added on the JS thread while raster jobs may read
+ * them on worker threads. Readers of text_glyph, text_origin and
+ * atlas_pixels off that thread hold the shared lock while they do.
+ */
+void atlas_lock_shared();
+void atlas_unlock_shared();
+
+uint8_t atlas_has_glyph(uint32_t font, uint32_t codepoint);
+
+// instance may be NULL, the texture is then updated when text is drawn next
+uint8_t atlas_add_glyph(UiInstance *instance, uint32_t font,
+                        uint32_t codepoint, const uint8_t *alpha, uint32_t w,
+                        uint32_t h, float bearing_x, float bearing_y,
+                        float advance);
+
+float measure_text(uint32_t font, const uint32_t *codepoints, uint32_t count);
+
+Glyph *text_glyph(uint32_t font, uint32_t codepoint);
+uint8_t text_font_exists(uint32_t font);
+float text_origin(uint32_t font, const uint32_t *codepoints, uint32_t count,
+                  uint8_t align, uint8_t baseline, float *base);
+// single channel, atlas_size() pixels square, NULL before the first glyph
+const uint8_t *atlas_pixels();
+uint32_t atlas_size();
+
+int32_t add_text(UiInstance *instance);
+uint8_t remove_text(UiInstance *instance, int32_t id);
+uint8_t set_text(UiInstance *instance, int32_t id, uint32_t font,
+                 const uint32_t *codepoints, uint32_t count, float x, float y,
+                 uint8_t align, uint8_t baseline);
+uint8_t set_text_style(UiInstance *instance, int32_t id, uint8_t r, uint8_t g,
+                       uint8_t b, uint8_t a);
+uint8_t set_text_visible(UiInstance *instance, int32_t id, uint8_t visible);
+
+void dispose_texts(UiInstance *instance);
+
+// transform maps buffer pixels to window pixels, xy origin and zw scale
+void render_texts(UiInstance *instance, Vec4f transform);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+#include "tiled.h"
+#include "upload.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t level_span(TiledImage *tiled, uint32_t level) {
+  return tiled->tile_size << level;
+}
+
+static uint32_t level_cols(TiledImage *tiled, uint32_t level) {
+  uint32_t span = level_span(tiled, level);
+  return (tiled->source.w + span - 1) / span;
+}
+
+static uint32_t level_rows(TiledImage *tiled, uint32_t level) {
+  uint32_t span = level_span(tiled, level);
+  return (tiled->source.h + span - 1) / span;
+}
+
+static void release_tile(TiledImage *tiled, Tile *tile) {
+  const uint8_t pixel_size = get_buffer_pixel_size(&tiled->source);
+  glDeleteTextures(1, &tile->texture);
+  tiled->resident -= (size_t)tile->w * tile->h * pixel_size;
+  tile->texture = 0;
+  tile->dirty = 1;
+}
+
+void dispose_tiled_image(TiledImage *tiled) {
+  for (uint32_t level = 0; level < tiled->levels; level++) {
+    uint32_t count = level_cols(tiled, level) * level_rows(tiled, level);
+    for (uint32_t i = 0; i < count; i++) {
+      if (tiled->tiles[level][i].texture)
+        release_tile(tiled, &tiled->tiles[level][i]);
+    }
+    free(tiled->tiles[level]);
+  }
+  free(tiled->tiles);
+  free(tiled->source.buffer);
+  free(tiled->scratch);
+  free(tiled);
+}
+
+uint8_t set_tiled_image(UiInstance *instance, uint32_t w, uint32_t h,
+                        uint32_t tile_size) {
+  glfwMakeContextCurrent(instance->window);
+  size_t budget = 256 * 1024 * 1024;
+  if (instance->tiled) {
+    budget = instance->tiled->budget;
+    dispose_tiled_image(instance->tiled);
+    instance->tiled = NULL;
+  }
+  instance->needs_render = 1;
+  if (w == 0 || h == 0)
+    return 0;
+  GLint max_size = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+  if (tile_size == 0)
+    tile_size = 512;
+  if (max_size > 0 && tile_size > (uint32_t)max_size)
+    tile_size = max_size;
+
+  TiledImage *tiled = calloc(1, sizeof(TiledImage));
+  tiled->source.type = instance->render_buffer.type;
+  image_buffer_resize(&tiled->source, w, h);
+  if (!tiled->source.buffer) {
+    free(tiled);
+    return 1;
+  }
+  tiled->tile_size = tile_size;
+  tiled->budget = budget;
+  // add levels until the whole image fits into a single tile
+  tiled->levels = 1;
+  while (level_cols(tiled, tiled->levels - 1) > 1 ||
+         level_rows(tiled, tiled->levels - 1) > 1)
+    tiled->levels++;
+  tiled->tiles = calloc(tiled->levels, sizeof(Tile *));
+  for (uint32_t level = 0; level < tiled->levels; level++) {
+    uint32_t count = level_cols(tiled, level) * level_rows(tiled, level);
+    tiled->tiles[level] = calloc(count, sizeof(Tile));
+    for (uint32_t i = 0; i < count; i++)
+      tiled->tiles[level][i].dirty = 1;
+  }
+  tiled->scratch = malloc((size_t)tile_size * tile_size *
+                          get_buffer_pixel_size(&tiled->source));
+  // tiles take the same upload paths as whole images
+  if (tiled->source.type == RGB || tiled->source.type == BGRA)
+    upload_calibrate();
+  instance->tiled = tiled;
+  return 0;
+}
+
+uint8_t tiled_image_write(UiInstance *instance, const uint8_t *data,
+                          uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  TiledImage *tiled = instance->tiled;
+  if (!tiled || x >= tiled->source.w || y >= tiled->source.h)
+    return 1;
+  // an empty rectangle changes nothing, the tile ranges below need w, h > 0
+  if (w == 0 || h == 0)
+    return 0;
+  const uint8_t pixel_size = get_buffer_pixel_size(&tiled->source);
+  const size_t in_stride = (size_t)w * pixel_size;
+  if (w > tiled->source.w - x)
+    w = tiled->source.w - x;
+  if (h > tiled->source.h - y)
+    h = tiled->source.h - y;
+  for (uint32_t row = 0; row < h; row++)
+    memcpy(tiled->source.buffer +
+               ((size_t)(y + row) * tiled->source.w + x) * pixel_size,
+           data + row * in_stride, (size_t)w * pixel_size);
+  for (uint32_t level = 0; level < tiled->levels; level++) {
+    uint32_t span = level_span(tiled, level);
+    uint32_t cols = level_cols(tiled, level);
+    uint32_t rows = level_rows(tiled, level);
+    uint32_t r1 = (y + h - 1) / span, c1 = (x + w - 1) / span;
+    if (r1 >= rows)
+      r1 = rows - 1;
+    if (c1 >= cols)
+      c1 = cols - 1;
+    for (uint32_t r = y / span; r <= r1; r++) {
+      for (uint32_t c = x / span; c <= c1; c++)
+        tiled->tiles[level][r * cols + c].dirty = 1;
+    }
+  }
+  instance->needs_render = 1;
+  return 0;
+}
+
+uint8_t set_tile_budget(UiInstance *instance, uint32_t megabytes) {
+  if (!instance->tiled || megabytes == 0)
+    return 1;
+  instance->tiled->budget = (size_t)megabytes * 1024 * 1024;
+  instance->needs_render = 1;
+  return 0;
+}
+
+static void evict_tiles(TiledImage *tiled, size_t needed) {
+  while (tiled->resident + needed > tiled->budget) {
+    Tile *lru = NULL;
+    for (uint32_t level = 0; level < tiled->levels; level++) {
+      uint32_t count = level_cols(tiled, level) * level_rows(tiled, level);
+      for (uint32_t i = 0; i < count; i++) {
+        Tile *tile = &tiled->tiles[level][i];
+        // tiles drawn in this frame are never evicted
+        if (!tile->texture || tile->last_used == tiled->frame)
+          continue;
+        if (!lru || tile->last_used < lru->last_used)
+          lru = tile;
+      }
+    }
+    if (!lru)
+      return;
+    release_tile(tiled, lru);
+  }
+}
+
+static void upload_tile(TiledImage *tiled, Tile *tile, uint32_t level,
+                        uint32_t x0, uint32_t y0) {
+  Image *source = &tiled->source;
+  const uint8_t pixel_size = get_buffer_pixel_size(source);
+  const uint32_t span = level_span(tiled, level);
+  uint32_t src_w = source->w - x0 < span ? source->w - x0 : span;
+  uint32_t src_h = source->h - y0 < span ? source->h - y0 : span;
+  uint32_t w = (src_w + (1 << level) - 1) >> level;
+  uint32_t h = (src_h + (1 << level) - 1) >> level;
+  if (!tile->texture) {
+    evict_tiles(tiled, (size_t)w * h * pixel_size);
+    glGenTextures(1, &tile->texture);
+    glBindTexture(GL_TEXTURE_2D, tile->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+                    image_filter(source));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    image_filter(source));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, upload_internal_format(source), w, h, 0,
+                 get_type_enum(source, 0), get_type_enum(source, 2), NULL);
+    upload_texture_setup(source);
+    tile->w = w;
+    tile->h = h;
+    tiled->resident += (size_t)w * h * pixel_size;
+  } else {
+    glBindTexture(GL_TEXTURE_2D, tile->texture);
+  }
+  if (level == 0) {
+    // straight out of the source, the row length skips the other tiles
+    upload_region(source, 0, 0, w, h, source->buffer, source->w, x0, y0);
+  } else {
+    // nearest sampled, keeps discrete values like wafer map bins intact
+    for (uint32_t y = 0; y < h; y++) {
+      const uint8_t *row =
+          source->buffer +
+          ((size_t)(y0 + (y << level)) * source->w + x0) * pixel_size;
+      uint8_t *out = tiled->scratch + (size_t)y * w * pixel_size;
+      for (uint32_t x = 0; x < w; x++)
+        memcpy(out + (size_t)x * pixel_size,
+               row + ((size_t)x << level) * pixel_size, pixel_size);
+    }
+    upload_pixels(source, 0, 0, w, h, tiled->scratch, w);
+  }
+  tile->dirty = 0;
+}
+
+void render_tiled_image(UiInstance *instance, Shader *shader,
+                        Vec2f image_pos, Vec2f image_size, Vec4f view) {
+  TiledImage *tiled = instance->tiled;
+  tiled->frame++;
+  const float scale_x = image_size.x / view.z;
+  const float scale_y = image_size.y / view.w;
+  // pick the level closest to one texel per window pixel
+  const float texels_per_pixel = view.z / image_size.x;
+  uint32_t level = 0;
+  while (level + 1 < tiled->levels &&
+         (float)(2u << level) <= texels_per_pixel)
+    level++;
+  const uint32_t span = level_span(tiled, level);
+  const uint32_t cols = level_cols(tiled, level);
+  const uint32_t rows = level_rows(tiled, level);
+  int64_t c0 = view.x > 0 ? (int64_t)(view.x / span) : 0;
+  int64_t r0 = view.y > 0 ? (int64_t)(view.y / span) : 0;
+  int64_t c1 = (int64_t)((view.x + view.z) / span);
+  int64_t r1 = (int64_t)((view.y + view.w) / span);
+  if (c1 >= cols)
+    c1 = cols - 1;
+  if (r1 >= rows)
+    r1 = rows - 1;
+
+  glEnable(GL_SCISSOR_TEST);
+  glScissor((GLint)image_pos.x,
+            (GLint)(instance->window_height - image_pos.y - image_size.y),
+            (GLsizei)(image_size.x + 0.5f), (GLsizei)(image_size.y + 0.5f));
+  shader_set4f(shader, "view", 0, 0, 1, 1);
+  glActiveTexture(GL_TEXTURE0);
+  for (int64_t r = r0; r <= r1; r++) {
+    for (int64_t c = c0; c <= c1; c++) {
+      Tile *tile = &tiled->tiles[level][r * cols + c];
+      uint32_t x0 = c * span, y0 = r * span;
+      tile->last_used = tiled->frame;
+      if (!tile->texture || tile->dirty)
+        upload_tile(tiled, tile, level, x0, y0);
+      else
+        glBindTexture(GL_TEXTURE_2D, tile->texture);
+      // edge tiles cover less than a full span
+      Vec2f pos = {image_pos.x + (x0 - view.x) * scale_x,
+                   image_pos.y + (y0 - view.y) * scale_y};
+      Vec2f size = {(float)(tile->w << level) * scale_x,
+                    (float)(tile->h << level) * scale_y};
+      SimpleShaderEntry entry = {normalize(instance, pos), size};
+      glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SimpleShaderEntry), &entry);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 6, 1);
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glDisable(GL_SCISSOR_TEST);
+}
@@ -0,0 +1,50 @@
+#ifndef TILED_H
+#define TILED_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  GLuint texture;
+  uint32_t w, h;
+  uint8_t dirty;
+  uint64_t last_used;
+} Tile;
+
+/*
+ * Image split into square tiles with their own textures, for buffers larger
+ * than GL_MAX_TEXTURE_SIZE. Every level halves the resolution of the one
+ * before it, level 0 is the source itself. Tiles are only uploaded when they
+ * are visible and least recently used ones are evicted above the budget.
+ */
+typedef struct TiledImage {
+  Image source;
+  uint32_t tile_size;
+  uint32_t levels;
+  Tile **tiles;
+  size_t budget;
+  size_t resident;
+  uint64_t frame;
+  uint8_t *scratch;
+} TiledImage;
+
+uint8_t set_tiled_image(UiInstance *instance, uint32_t w, uint32_t h,
+                        uint32_t tile_size);
+
+uint8_t tiled_image_write(UiInstance *instance, const uint8_t *data,
+                          uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+uint8_t set_tile_budget(UiInstance *instance, uint32_t megabytes);
+
+void dispose_tiled_image(TiledImage *tiled);
+
+void render_tiled_image(UiInstance *instance, Shader *shader,
+                        Vec2f image_pos, Vec2f image_size, Vec4f view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+#include "upload.h"
+#include "convert.h"
+#include "startup.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PROBE_SIZE 512
+#define PROBE_RUNS 4
+
+// indexed by the byte image types RGBA, RGB and BGRA
+static enum UploadPath g_paths[3];
+static double g_rates[3][2];
+static uint8_t g_calibrated = 0;
+static uint8_t *g_staging = NULL;
+static size_t g_staging_size = 0;
+
+static enum UploadPath upload_path(Image *image) {
+  return image->type <= BGRA ? g_paths[image->type] : UPLOAD_DIRECT;
+}
+
+static GLint unpack_alignment(const uint8_t *pixels, size_t stride) {
+  const uintptr_t bits = (uintptr_t)pixels | stride;
+  if (bits % 8 == 0)
+    return 8;
+  if (bits % 4 == 0)
+    return 4;
+  return bits % 2 == 0 ? 2 : 1;
+}
+
+static const uint8_t *expand_rgb(const uint8_t *pixels, uint32_t w,
+                                 uint32_t h, uint32_t row_length) {
+  const size_t size = (size_t)w * h * 4;
+  if (size > g_staging_size) {
+    uint8_t *resized = realloc(g_staging, size);
+    if (!resized)
+      return NULL;
+    g_staging = resized;
+    g_staging_size = size;
+  }
+  if (row_length == w) {
+    convert_pixels(pixels, "rgb", g_staging, "rgba", w, h);
+    return g_staging;
+  }
+  for (uint32_t y = 0; y < h; y++)
+    convert_pixels(pixels + (size_t)y * row_length * 3, "rgb",
+                   g_staging + (size_t)y * w * 4, "rgba", w, 1);
+  return g_staging;
+}
+
+GLint upload_internal_format(Image *image) {
+  if (upload_path(image) == UPLOAD_EXPAND)
+    return GL_RGBA8;
+  return get_type_enum(image, 1);
+}
+
+void upload_texture_setup(Image *image) {
+  GLint swizzle[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+  if (upload_path(image) == UPLOAD_SWIZZLE) {
+    swizzle[0] = GL_BLUE;
+    swizzle[2] = GL_RED;
+  }
+  glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+void upload_region(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                   uint32_t h, const uint8_t *source, uint32_t row_length,
+                   uint32_t skip_x, uint32_t skip_y) {
+  if (w == 0 || h == 0)
+    return;
+  GLenum format = get_type_enum(image, 0);
+  size_t pixel_size = get_buffer_pixel_size(image);
+  const enum UploadPath path = upload_path(image);
+  if (path == UPLOAD_SWIZZLE)
+    format = GL_RGBA;
+  // without staging memory rgb still goes into the rgba storage directly
+  const uint8_t *staged =
+      path == UPLOAD_EXPAND
+          ? expand_rgb(source +
+                           ((size_t)skip_y * row_length + skip_x) * pixel_size,
+                       w, h, row_length)
+          : NULL;
+  if (staged) {
+    source = staged;
+    row_length = w;
+    skip_x = skip_y = 0;
+    format = GL_RGBA;
+    pixel_size = 4;
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT,
+                unpack_alignment(source, (size_t)row_length * pixel_size));
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length == w ? 0 : row_length);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, skip_x);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, skip_y);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format,
+                  get_type_enum(image, 2), source);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+void upload_pixels(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                   uint32_t h, const uint8_t *pixels, uint32_t row_length) {
+  upload_region(image, x, y, w, h, pixels, row_length, 0, 0);
+}
+
+// GB/s of source pixels through one path, including any CPU conversion
+static double probe(enum ImageType type, enum UploadPath path,
+                    uint8_t *pixels) {
+  Image image = {0};
+  image.w = image.h = PROBE_SIZE;
+  image.type = type;
+  g_paths[type] = path;
+  glTexImage2D(GL_TEXTURE_2D, 0, upload_internal_format(&image), PROBE_SIZE,
+               PROBE_SIZE, 0, get_type_enum(&image, 0),
+               get_type_enum(&image, 2), NULL);
+  upload_texture_setup(&image);
+  // the first upload can include lazy allocation in the driver
+  upload_pixels(&image, 0, 0, PROBE_SIZE, PROBE_SIZE, pixels, PROBE_SIZE);
+  glFinish();
+  double start = startup_now();
+  for (uint32_t i = 0; i < PROBE_RUNS; i++)
+    upload_pixels(&image, 0, 0, PROBE_SIZE, PROBE_SIZE, pixels, PROBE_SIZE);
+  glFinish();
+  double seconds = (startup_now() - start) / 1000.0;
+  double bytes = (double)PROBE_SIZE * PROBE_SIZE *
+                 get_buffer_pixel_size(&image) * PROBE_RUNS;
+  return seconds > 0 ? bytes / seconds / 1e9 : 0;
+}
+
+void upload_calibrate() {
+  if (g_calibrated)
+    return;
+  g_calibrated = 1;
+  double start = startup_now();
+  uint8_t *pixels = malloc((size_t)PROBE_SIZE * PROBE_SIZE * 4);
+  if (!pixels)
+    return;
+  for (size_t i = 0; i < (size_t)PROBE_SIZE * PROBE_SIZE * 4; i++)
+    pixels[i] = (uint8_t)(i * 7919 >> 3);
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  g_rates[RGBA][0] = probe(RGBA, UPLOAD_DIRECT, pixels);
+  g_rates[RGB][0] = probe(RGB, UPLOAD_DIRECT, pixels);
+  g_rates[RGB][1] = probe(RGB, UPLOAD_EXPAND, pixels);
+  g_rates[BGRA][0] = probe(BGRA, UPLOAD_DIRECT, pixels);
+  g_rates[BGRA][1] = probe(BGRA, UPLOAD_SWIZZLE, pixels);
+  // timings are noisy, the direct path has to lose clearly to be replaced
+  g_paths[RGB] = g_rates[RGB][1] > g_rates[RGB][0] * 1.1 ? UPLOAD_EXPAND
+                                                         : UPLOAD_DIRECT;
+  g_paths[BGRA] = g_rates[BGRA][1] > g_rates[BGRA][0] * 1.1 ? UPLOAD_SWIZZLE
+                                                            : UPLOAD_DIRECT;
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDeleteTextures(1, &texture);
+  free(pixels);
+  free(g_staging);
+  g_staging = NULL;
+  g_staging_size = 0;
+  startup_record(STARTUP_UPLOAD_PROBE, start);
+}
+
+uint8_t get_upload_stats(double *out) {
+  for (uint32_t i = 0; i < 3; i++) {
+    out[i * 3] = g_paths[i];
+    out[i * 3 + 1] = g_rates[i][0];
+    out[i * 3 + 2] = g_rates[i][1];
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include "bun-ui.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum UploadPath {
+  // the buffer's own format, the driver converts if it has to
+  UPLOAD_DIRECT,
+  // rgb expanded to rgba on the CPU into a staging buffer
+  UPLOAD_EXPAND,
+  // bgra bytes uploaded as rgba, the texture swizzles red and blue back
+  UPLOAD_SWIZZLE
+};
+
+/*
+ * Drivers differ in which layouts they take without a slow conversion, so
+ * the first upload of an rgb or bgra image (or prewarm) times each path on a
+ * scratch texture and keeps the faster one. Needs a current context.
+ */
+void upload_calibrate();
+
+// internal format of the texture storage holding image
+GLint upload_internal_format(Image *image);
+
+// applies the swizzle of the path to the bound texture after allocating it
+void upload_texture_setup(Image *image);
+
+/*
+ * Uploads w * h pixels to x, y of the bound texture, rows of pixels are
+ * row_length pixels apart. The unpack alignment follows the data instead of
+ * always being 1.
+ */
+void upload_pixels(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                   uint32_t h, const uint8_t *pixels, uint32_t row_length);
+
+// same with the pixels starting skip_x, skip_y into source, the offset is
+// passed as GL_UNPACK_SKIP_PIXELS/ROWS so the alignment is taken from source
+void upload_region(Image *image, uint32_t x, uint32_t y, uint32_t w,
+                   uint32_t h, const uint8_t *source, uint32_t row_length,
+                   uint32_t skip_x, uint32_t skip_y);
+
+/*
+ * For rgba, rgb and bgra (in that order): the chosen UploadPath, the direct
+ * path's GB/s and the alternative's GB/s, 0 when not measured.
+ */
+uint8_t get_upload_stats(double *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif